@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dvc {
+
+// A bump allocator for nodes that all die together.  Objects are carved out
+// of large blocks and never freed individually; destroying the arena runs
+// the destructors of the non-trivially destructible objects, in reverse
+// order of construction, and releases the blocks.
+class arena {
+ public:
+  static constexpr size_t block_size = 64 << 10;
+
+  arena() = default;
+
+  arena(arena&& that) noexcept
+      : blocks(std::move(that.blocks)),
+        cur(std::exchange(that.cur, nullptr)),
+        end(std::exchange(that.end, nullptr)),
+        destructors(std::exchange(that.destructors, nullptr)) {}
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  ~arena() {
+    for (destructor* d = destructors; d != nullptr; d = d->next)
+      d->destroy(d->object);
+  }
+
+  void* allocate(size_t size, size_t align) {
+    uintptr_t p = (uintptr_t(cur) + align - 1) & ~uintptr_t(align - 1);
+    if (cur == nullptr || p + size > uintptr_t(end)) {
+      grow(size + align);
+      p = (uintptr_t(cur) + align - 1) & ~uintptr_t(align - 1);
+    }
+    cur = reinterpret_cast<char*>(p + size);
+    return reinterpret_cast<void*>(p);
+  }
+
+  template<typename T, typename... Args>
+  T* make(Args&&... args) {
+    T* t = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      destructors = new (allocate(sizeof(destructor), alignof(destructor)))
+          destructor{[](void* p) { static_cast<T*>(p)->~T(); }, t, destructors};
+    }
+    return t;
+  }
+
+ private:
+  struct destructor {
+    void (*destroy)(void*);
+    void* object;
+    destructor* next;
+  };
+
+  void grow(size_t min_size) {
+    size_t size = std::max(block_size, min_size);
+    blocks.emplace_back(new char[size]);
+    cur = blocks.back().get();
+    end = cur + size;
+  }
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char* cur = nullptr;
+  char* end = nullptr;
+  destructor* destructors = nullptr;
+};
+
+}  // namespace dvc
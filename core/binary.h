@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <glog/logging.h>
+
+namespace dvc {
+
+// 64-bit FNV-1a: the offset basis, and the hash of s continuing from h.
+inline constexpr uint64_t fnv1a_basis = 14695981039346656037u;
+
+constexpr uint64_t fnv1a(uint64_t h, std::string_view s) {
+  for (char c : s) {
+    h ^= uint8_t(c);
+    h *= 1099511628211u;
+  }
+  return h;
+}
+
+// Writes fixed-width little-endian fields into a growing buffer.
+class binary_writer {
+ public:
+  void u32(uint32_t v) {
+    for (int i = 0; i < 4; i++) out += char(v >> (8 * i));
+  }
+
+  void u64(uint64_t v) {
+    for (int i = 0; i < 8; i++) out += char(v >> (8 * i));
+  }
+
+  void bytes(std::string_view s) { out += s; }
+
+  // The bytes of padding that align n bytes to a multiple of 4.
+  static size_t padding(size_t n) { return -n & 3; }
+
+  // Pads the output to a multiple of 4 bytes with zeros.
+  void pad() { out.append(padding(out.size()), '\0'); }
+
+  // Overwrites the u32 written at offset pos.
+  void patch_u32(size_t pos, uint32_t v) {
+    DCHECK_LE(pos + 4, out.size());
+    for (int i = 0; i < 4; i++) out[pos + i] = char(v >> (8 * i));
+  }
+
+  // Overwrites the u64 written at offset pos.
+  void patch_u64(size_t pos, uint64_t v) {
+    patch_u32(pos, uint32_t(v));
+    patch_u32(pos + 4, uint32_t(v >> 32));
+  }
+
+  size_t size() const { return out.size(); }
+  const std::string& str() const { return out; }
+  std::string& str() { return out; }
+
+ private:
+  std::string out;
+};
+
+// Reads what binary_writer wrote, from a borrowed buffer such as a mapped
+// file.  Reading past the end fails the reader rather than the process, so
+// that corrupt input can be rejected: every later read returns zeros or an
+// empty string, and ok() returns false.
+class binary_reader {
+ public:
+  explicit binary_reader(std::string_view data) : data(data) {}
+
+  uint32_t u32() {
+    const unsigned char* p = advance(4);
+    if (!p) return 0;
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 |
+           uint32_t(p[3]) << 24;
+  }
+
+  uint64_t u64() {
+    uint64_t lo = u32();
+    return lo | uint64_t(u32()) << 32;
+  }
+
+  std::string_view bytes(size_t n) {
+    const unsigned char* p = advance(n);
+    if (!p) return {};
+    return std::string_view(reinterpret_cast<const char*>(p), n);
+  }
+
+  // Reads a u32 count of items that take at least item_size bytes each, or
+  // fails if the rest of the input cannot hold that many.  This bounds what
+  // a caller allocates for a corrupt count.
+  uint32_t count(size_t item_size) {
+    uint32_t n = u32();
+    if (n > remaining() / item_size) {
+      fail();
+      return 0;
+    }
+    return n;
+  }
+
+  void skip(size_t n) { advance(n); }
+
+  // Marks the input as corrupt.
+  void fail() {
+    failed = true;
+    pos_ = data.size();
+  }
+
+  bool ok() const { return !failed; }
+  size_t pos() const { return pos_; }
+  size_t remaining() const { return data.size() - pos_; }
+
+ private:
+  const unsigned char* advance(size_t n) {
+    if (n > remaining()) {
+      fail();
+      return nullptr;
+    }
+    const char* p = data.data() + pos_;
+    pos_ += n;
+    return reinterpret_cast<const unsigned char*>(p);
+  }
+
+  std::string_view data;
+  size_t pos_ = 0;
+  bool failed = false;
+};
+
+}  // namespace dvc
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define DVC_BYTESCAN_X86 1
+#endif
+
+namespace dvc {
+
+// A set of bytes given as a handful of inclusive ranges.  The ranges drive the
+// SIMD matchers; the 256-entry table drives the scalar ones.
+class byte_class {
+ public:
+  struct range {
+    char lo, hi;
+  };
+
+  static constexpr size_t max_ranges = 6;
+
+  constexpr byte_class(std::initializer_list<range> rs) {
+    for (range r : rs) {
+      ranges[num_ranges++] = r;
+      for (int c = (unsigned char)r.lo; c <= (unsigned char)r.hi; c++)
+        table[c] = true;
+    }
+  }
+
+  constexpr bool contains(char c) const { return table[(unsigned char)c]; }
+
+  std::array<range, max_ranges> ranges = {};
+  size_t num_ranges = 0;
+  std::array<bool, 256> table = {};
+};
+
+// Bulk byte scanning primitives over [p, end).  Each returns the first
+// position at which the scan stopped, or end.
+namespace bytescan {
+
+namespace scalar {
+
+inline const char* skip_while(const char* p, const char* end,
+                              const byte_class& cls) {
+  while (p != end && cls.contains(*p)) p++;
+  return p;
+}
+
+inline const char* find_first_of(const char* p, const char* end,
+                                 const byte_class& cls) {
+  while (p != end && !cls.contains(*p)) p++;
+  return p;
+}
+
+inline size_t count(const char* p, const char* end, char c) {
+  size_t n = 0;
+  for (; p != end; p++) n += (*p == c);
+  return n;
+}
+
+}  // namespace scalar
+
+#ifdef DVC_BYTESCAN_X86
+
+namespace sse2 {
+
+inline __m128i match(__m128i x, const byte_class& cls) {
+  __m128i m = _mm_setzero_si128();
+  for (size_t i = 0; i < cls.num_ranges; i++) {
+    const byte_class::range& r = cls.ranges[i];
+    __m128i t = _mm_sub_epi8(x, _mm_set1_epi8(r.lo));
+    __m128i span = _mm_set1_epi8(char(r.hi - r.lo));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(t, span), t));
+  }
+  return m;
+}
+
+inline const char* skip_while(const char* p, const char* end,
+                              const byte_class& cls) {
+  for (; end - p >= 16; p += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i*)p);
+    unsigned mask = ~unsigned(_mm_movemask_epi8(match(x, cls))) & 0xFFFF;
+    if (mask) return p + __builtin_ctz(mask);
+  }
+  return scalar::skip_while(p, end, cls);
+}
+
+inline const char* find_first_of(const char* p, const char* end,
+                                 const byte_class& cls) {
+  for (; end - p >= 16; p += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i*)p);
+    unsigned mask = _mm_movemask_epi8(match(x, cls));
+    if (mask) return p + __builtin_ctz(mask);
+  }
+  return scalar::find_first_of(p, end, cls);
+}
+
+inline size_t count(const char* p, const char* end, char c) {
+  size_t n = 0;
+  __m128i cc = _mm_set1_epi8(c);
+  for (; end - p >= 16; p += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i*)p);
+    n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(x, cc)));
+  }
+  return n + scalar::count(p, end, c);
+}
+
+}  // namespace sse2
+
+namespace avx2 {
+
+__attribute__((target("avx2"))) inline __m256i match(__m256i x,
+                                                     const byte_class& cls) {
+  __m256i m = _mm256_setzero_si256();
+  for (size_t i = 0; i < cls.num_ranges; i++) {
+    const byte_class::range& r = cls.ranges[i];
+    __m256i t = _mm256_sub_epi8(x, _mm256_set1_epi8(r.lo));
+    __m256i span = _mm256_set1_epi8(char(r.hi - r.lo));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(t, span), t));
+  }
+  return m;
+}
+
+__attribute__((target("avx2"))) inline const char* skip_while(
+    const char* p, const char* end, const byte_class& cls) {
+  for (; end - p >= 32; p += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)p);
+    uint32_t mask = ~uint32_t(_mm256_movemask_epi8(match(x, cls)));
+    if (mask) return p + __builtin_ctz(mask);
+  }
+  return sse2::skip_while(p, end, cls);
+}
+
+__attribute__((target("avx2"))) inline const char* find_first_of(
+    const char* p, const char* end, const byte_class& cls) {
+  for (; end - p >= 32; p += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)p);
+    uint32_t mask = _mm256_movemask_epi8(match(x, cls));
+    if (mask) return p + __builtin_ctz(mask);
+  }
+  return sse2::find_first_of(p, end, cls);
+}
+
+__attribute__((target("avx2"))) inline size_t count(const char* p,
+                                                    const char* end, char c) {
+  size_t n = 0;
+  __m256i cc = _mm256_set1_epi8(c);
+  for (; end - p >= 32; p += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)p);
+    n += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, cc)));
+  }
+  return n + sse2::count(p, end, c);
+}
+
+}  // namespace avx2
+
+#endif  // DVC_BYTESCAN_X86
+
+// The best implementation for the running CPU, chosen on first use.
+struct implementation {
+  const char* (*skip_while)(const char*, const char*, const byte_class&);
+  const char* (*find_first_of)(const char*, const char*, const byte_class&);
+  size_t (*count)(const char*, const char*, char);
+};
+
+inline const implementation& best() {
+  static const implementation impl = [] {
+#ifdef DVC_BYTESCAN_X86
+    if (__builtin_cpu_supports("avx2"))
+      return implementation{avx2::skip_while, avx2::find_first_of,
+                            avx2::count};
+    return implementation{sse2::skip_while, sse2::find_first_of, sse2::count};
+#else
+    return implementation{scalar::skip_while, scalar::find_first_of,
+                          scalar::count};
+#endif
+  }();
+  return impl;
+}
+
+inline const char* skip_while(const char* p, const char* end,
+                              const byte_class& cls) {
+  return best().skip_while(p, end, cls);
+}
+
+inline const char* find_first_of(const char* p, const char* end,
+                                 const byte_class& cls) {
+  return best().find_first_of(p, end, cls);
+}
+
+inline size_t count(const char* p, const char* end, char c) {
+  return best().count(p, end, c);
+}
+
+}  // namespace bytescan
+
+}  // namespace dvc
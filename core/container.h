@@ -1,7 +1,14 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
+#include <vector>
+#include <glog/logging.h>
 
 namespace dvc {
 
@@ -22,4 +29,282 @@ void sort(Container& container) {
   std::sort(container.begin(), container.end());
 }
 
+// The type keys are looked up by: std::string keys are looked up by
+// std::string_view, so that lookups never build a temporary string.
+template<typename Key>
+using lookup_key_t = std::conditional_t<std::is_same_v<Key, std::string>,
+                                        std::string_view, Key>;
+
+// An ordered map stored as a sorted vector of pairs.  Meant for maps that are
+// built once and then only read: lookups are binary searches over contiguous
+// memory, inserts in key order append, any other insert shifts the tail.
+template<typename Key, typename T>
+class flat_map {
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key, T>;
+  using lookup_type = lookup_key_t<Key>;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  flat_map() = default;
+
+  // Builds the map from unordered entries in one sort.  Duplicate keys are
+  // fatal.
+  explicit flat_map(std::vector<value_type> unsorted)
+      : entries(std::move(unsorted)) {
+    std::sort(entries.begin(), entries.end(),
+              [](const value_type& a, const value_type& b) {
+                return a.first < b.first;
+              });
+    auto dup = std::adjacent_find(entries.begin(), entries.end(),
+                                  [](const value_type& a, const value_type& b) {
+                                    return a.first == b.first;
+                                  });
+    CHECK(dup == entries.end()) << "flat_map: duplicate key";
+  }
+
+  template<typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+    lookup_type k = key;
+    iterator it = entries.end();
+    if (!entries.empty() && !(entries.back().first < k)) {
+      it = lower_bound(k);
+      if (it != entries.end() && it->first == k) return {it, false};
+    }
+    it = entries.emplace(it, std::piecewise_construct,
+                         std::forward_as_tuple(std::forward<K>(key)),
+                         std::forward_as_tuple(std::forward<Args>(args)...));
+    return {it, true};
+  }
+
+  template<typename P>
+  std::pair<iterator, bool> insert(P&& p) {
+    return try_emplace(std::forward<P>(p).first, std::forward<P>(p).second);
+  }
+
+  iterator find(const lookup_type& key) {
+    iterator it = lower_bound(key);
+    return it != entries.end() && it->first == key ? it : entries.end();
+  }
+
+  const_iterator find(const lookup_type& key) const {
+    return const_cast<flat_map*>(this)->find(key);
+  }
+
+  size_t count(const lookup_type& key) const { return find(key) != end(); }
+
+  T& at(const lookup_type& key) {
+    iterator it = find(key);
+    CHECK(it != entries.end()) << "flat_map::at: no such key";
+    return it->second;
+  }
+
+  const T& at(const lookup_type& key) const {
+    return const_cast<flat_map*>(this)->at(key);
+  }
+
+  T& operator[](const lookup_type& key) {
+    return try_emplace(Key(key)).first->second;
+  }
+
+  size_t erase(const lookup_type& key) {
+    iterator it = find(key);
+    if (it == entries.end()) return 0;
+    entries.erase(it);
+    return 1;
+  }
+
+  void reserve(size_t n) { entries.reserve(n); }
+  void clear() { entries.clear(); }
+  size_t size() const { return entries.size(); }
+  bool empty() const { return entries.empty(); }
+
+  iterator begin() { return entries.begin(); }
+  iterator end() { return entries.end(); }
+  const_iterator begin() const { return entries.begin(); }
+  const_iterator end() const { return entries.end(); }
+
+ private:
+  iterator lower_bound(const lookup_type& key) {
+    return std::lower_bound(
+        entries.begin(), entries.end(), key,
+        [](const value_type& a, const lookup_type& b) { return a.first < b; });
+  }
+
+  std::vector<value_type> entries;
+};
+
+// An unordered map using open addressing.  Entries are stored densely, in
+// insertion order, in one vector; a power-of-two table of slots probed
+// linearly maps hashes to entry indices.  Erasing moves the last entry into
+// the hole, so erasure does not preserve iteration order.
+template<typename Key, typename T, typename Hash = std::hash<lookup_key_t<Key>>>
+class dense_hash_map {
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key, T>;
+  using lookup_type = lookup_key_t<Key>;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  dense_hash_map() = default;
+
+  template<typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+    lookup_type k = key;
+    return try_emplace_hashed(Hash()(k), std::forward<K>(key),
+                              std::forward<Args>(args)...);
+  }
+
+  // As try_emplace, given Hash()(key), for callers that already computed it.
+  template<typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace_hashed(size_t key_hash, K&& key,
+                                               Args&&... args) {
+    lookup_type k = key;
+    uint64_t h = mix(key_hash);
+    size_t s = probe(k, h);
+    if (slots[s].entry != empty_slot)
+      return {entries.begin() + slots[s].entry, false};
+    if (4 * (entries.size() + 1) > 3 * slots.size()) {
+      rehash(2 * slots.size());
+      s = probe(k, h);
+    }
+    slots[s] = {uint32_t(h), uint32_t(entries.size())};
+    entries.emplace_back(std::piecewise_construct,
+                         std::forward_as_tuple(std::forward<K>(key)),
+                         std::forward_as_tuple(std::forward<Args>(args)...));
+    return {entries.end() - 1, true};
+  }
+
+  template<typename P>
+  std::pair<iterator, bool> insert(P&& p) {
+    return try_emplace(std::forward<P>(p).first, std::forward<P>(p).second);
+  }
+
+  iterator find(const lookup_type& key) {
+    return find_hashed(Hash()(key), key);
+  }
+
+  const_iterator find(const lookup_type& key) const {
+    return const_cast<dense_hash_map*>(this)->find(key);
+  }
+
+  // As find, given Hash()(key).
+  iterator find_hashed(size_t key_hash, const lookup_type& key) {
+    if (entries.empty()) return entries.end();
+    uint32_t e = slots[probe(key, mix(key_hash))].entry;
+    return e == empty_slot ? entries.end() : entries.begin() + e;
+  }
+
+  size_t count(const lookup_type& key) const { return find(key) != end(); }
+
+  T& at(const lookup_type& key) {
+    iterator it = find(key);
+    CHECK(it != entries.end()) << "dense_hash_map::at: no such key";
+    return it->second;
+  }
+
+  const T& at(const lookup_type& key) const {
+    return const_cast<dense_hash_map*>(this)->at(key);
+  }
+
+  T& operator[](const lookup_type& key) {
+    return try_emplace(Key(key)).first->second;
+  }
+
+  size_t erase(const lookup_type& key) {
+    if (entries.empty()) return 0;
+    size_t s = probe(key, hash(key));
+    uint32_t e = slots[s].entry;
+    if (e == empty_slot) return 0;
+    remove_slot(s);
+    uint32_t last = entries.size() - 1;
+    if (e != last) {
+      const value_type& moved = entries[last];
+      slots[probe(moved.first, hash(moved.first))].entry = e;
+      entries[e] = std::move(entries[last]);
+    }
+    entries.pop_back();
+    return 1;
+  }
+
+  void reserve(size_t n) {
+    entries.reserve(n);
+    size_t capacity = min_slots;
+    while (3 * capacity < 4 * n) capacity *= 2;
+    if (capacity > slots.size()) rehash(capacity);
+  }
+
+  void clear() {
+    entries.clear();
+    std::fill(slots.begin(), slots.end(), slot{});
+  }
+
+  size_t size() const { return entries.size(); }
+  bool empty() const { return entries.empty(); }
+
+  iterator begin() { return entries.begin(); }
+  iterator end() { return entries.end(); }
+  const_iterator begin() const { return entries.begin(); }
+  const_iterator end() const { return entries.end(); }
+
+ private:
+  static constexpr uint32_t empty_slot = UINT32_MAX;
+  static constexpr size_t min_slots = 16;
+
+  struct slot {
+    uint32_t hash = 0;
+    uint32_t entry = empty_slot;
+  };
+
+  // Fibonacci hashing spreads the weak low bits of e.g. pointer hashes.
+  static uint64_t mix(size_t key_hash) {
+    return uint64_t(key_hash) * 0x9E3779B97F4A7C15u >> 32;
+  }
+
+  static uint64_t hash(const lookup_type& key) { return mix(Hash()(key)); }
+
+  size_t mask() const { return slots.size() - 1; }
+
+  // The slot holding `key`, or the empty slot where it would go.
+  size_t probe(const lookup_type& key, uint64_t h) {
+    if (slots.empty()) rehash(min_slots);
+    for (size_t s = h & mask();; s = (s + 1) & mask()) {
+      const slot& sl = slots[s];
+      if (sl.entry == empty_slot) return s;
+      if (sl.hash == uint32_t(h) && entries[sl.entry].first == key) return s;
+    }
+  }
+
+  // Empties slot s, shifting later slots of the probe run back so that no
+  // tombstones are needed.
+  void remove_slot(size_t s) {
+    for (size_t next = (s + 1) & mask();; next = (next + 1) & mask()) {
+      if (slots[next].entry == empty_slot) break;
+      size_t home = slots[next].hash & mask();
+      if (((next - home) & mask()) >= ((next - s) & mask())) {
+        slots[s] = slots[next];
+        s = next;
+      }
+    }
+    slots[s] = slot{};
+  }
+
+  void rehash(size_t capacity) {
+    slots.assign(capacity, slot{});
+    for (uint32_t e = 0; e < entries.size(); e++) {
+      uint64_t h = hash(entries[e].first);
+      size_t s = h & mask();
+      while (slots[s].entry != empty_slot) s = (s + 1) & mask();
+      slots[s] = {uint32_t(h), e};
+    }
+  }
+
+  std::vector<value_type> entries;
+  std::vector<slot> slots;
+};
+
 }  // namespace dvc
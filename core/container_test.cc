@@ -0,0 +1,120 @@
+#include <glog/logging.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "core/container.h"
+
+namespace {
+
+// Hashes only the first character, so that keys pile up in long probe runs
+// and erase has to shift most of a run back.
+struct first_char_hash {
+  size_t operator()(std::string_view s) const {
+    return s.empty() ? 0 : uint8_t(s[0]);
+  }
+};
+
+template<typename Map>
+void check_equal(const Map& map,
+                 const std::unordered_map<std::string, int>& expected) {
+  CHECK_EQ(map.size(), expected.size());
+  size_t n = 0;
+  for (const auto& [key, value] : map) {
+    auto it = expected.find(key);
+    CHECK(it != expected.end()) << "unexpected key " << key;
+    CHECK_EQ(value, it->second) << key;
+    n++;
+  }
+  CHECK_EQ(n, expected.size());
+  for (const auto& [key, value] : expected) {
+    auto it = map.find(key);
+    CHECK(it != map.end()) << "missing key " << key;
+    CHECK_EQ(it->second, value) << key;
+  }
+}
+
+// Mirrors map in a std::unordered_map through a random mix of inserts,
+// erases and lookups, with keys drawn from a small set so that each is
+// inserted and erased many times.
+template<typename Hash>
+void test_against_unordered_map(uint32_t seed, size_t num_keys) {
+  dvc::dense_hash_map<std::string, int, Hash> map;
+  std::unordered_map<std::string, int> expected;
+  std::mt19937 rng(seed);
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < num_keys; i++)
+    keys.push_back(std::string(1, char('a' + i % 7)) + std::to_string(i));
+
+  for (int step = 0; step < 200000; step++) {
+    const std::string& key = keys[rng() % keys.size()];
+    std::string_view view = key;
+    int value = int(rng() % 1000);
+    switch (rng() % 6) {
+      case 0: {
+        auto [it, inserted] = map.try_emplace(view, value);
+        auto [eit, einserted] = expected.try_emplace(key, value);
+        CHECK_EQ(inserted, einserted) << key;
+        CHECK_EQ(it->second, eit->second) << key;
+        break;
+      }
+      case 1: {
+        auto [it, inserted] = map.try_emplace_hashed(Hash()(view), key, value);
+        auto [eit, einserted] = expected.try_emplace(key, value);
+        CHECK_EQ(inserted, einserted) << key;
+        CHECK_EQ(it->second, eit->second) << key;
+        break;
+      }
+      case 2:
+        map[view] = value;
+        expected[key] = value;
+        break;
+      case 3:
+      case 4:
+        CHECK_EQ(map.erase(view), expected.erase(key)) << key;
+        break;
+      case 5: {
+        auto it = map.find(view);
+        auto eit = expected.find(key);
+        CHECK_EQ(it == map.end(), eit == expected.end()) << key;
+        if (eit != expected.end()) CHECK_EQ(it->second, eit->second) << key;
+        auto hit = map.find_hashed(Hash()(view), view);
+        CHECK(hit == it) << key;
+        break;
+      }
+    }
+    if (step % 10007 == 0) check_equal(map, expected);
+  }
+  check_equal(map, expected);
+
+  // Erase everything, then refill after reserve(), which rehashes.
+  for (const std::string& key : keys)
+    CHECK_EQ(map.erase(key), expected.erase(key)) << key;
+  CHECK(map.empty());
+  map.reserve(4 * num_keys);
+  for (const std::string& key : keys) {
+    map.try_emplace(key, int(key.size()));
+    expected.try_emplace(key, int(key.size()));
+  }
+  check_equal(map, expected);
+
+  map.clear();
+  expected.clear();
+  check_equal(map, expected);
+  CHECK(map.find(keys[0]) == map.end());
+  CHECK_EQ(map.erase(keys[0]), 0u);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+
+  for (uint32_t seed : {1, 2, 3}) {
+    for (size_t num_keys : {10, 100, 3000}) {
+      test_against_unordered_map<std::hash<std::string_view>>(seed, num_keys);
+      test_against_unordered_map<first_char_hash>(seed, num_keys);
+    }
+  }
+}
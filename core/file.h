@@ -1,6 +1,23 @@
 #pragma once
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <exception>
 #include <fstream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <glog/logging.h>
 #include <experimental/filesystem>
 
@@ -8,6 +25,10 @@ namespace dvc {
 
 using fspath = std::experimental::filesystem::path;
 
+[[noreturn]] inline void throw_file_error(const dvc::fspath& fspath) {
+  throw std::system_error(errno, std::generic_category(), fspath.string());
+}
+
 class file_reader {
  public:
   file_reader(const dvc::fspath& fspath) {
@@ -37,53 +58,322 @@ class file_reader {
   std::ifstream ifs;
 };
 
-struct append_t {} append;
-struct truncate_t {} truncate;
+struct append_t {};
+inline constexpr append_t append{};
+struct truncate_t {};
+inline constexpr truncate_t truncate{};
+struct replace_t {};
+inline constexpr replace_t replace{};
+struct if_changed_t {};
+inline constexpr if_changed_t if_changed{};
 
+// Buffered file output.  Output accumulates in a user-space buffer and only
+// reaches the file when the buffer fills, on flush(), or on close().  Nothing
+// is flushed per line.
+//
+// With dvc::replace the output is written to a temporary file next to the
+// target and renamed over it on close(), so readers never see a partially
+// written file.  If the writer is destroyed during stack unwinding, the
+// temporary file is discarded and the target is left untouched.  Writers in
+// dvc::append and dvc::truncate modes instead flush what they hold, so that
+// the file keeps everything written to it, as it would unbuffered.
+//
+// dvc::if_changed holds the whole output in memory until close(), then
+// compares it with the existing target.  Identical output leaves the target,
+// and its mtime, alone; otherwise it is replaced as with dvc::replace.  This
+// keeps regenerated sources that did not change from triggering rebuilds.
 class file_writer {
  public:
+  static constexpr size_t buffer_size = 1 << 20;
+
   file_writer(const dvc::fspath& fspath, append_t) {
-    open(fspath, std::ios::ate);
+    open(fspath, O_APPEND);
   }
   file_writer(const dvc::fspath& fspath, truncate_t) {
-    open(fspath, std::ios::trunc);
+    open(fspath, O_TRUNC);
   }
+  file_writer(const dvc::fspath& fspath, replace_t) : target(fspath) {
+    open_temp();
+    buffer.reserve(buffer_size);
+  }
+  file_writer(const dvc::fspath& fspath, if_changed_t)
+      : target(fspath), deferred(true) {
+    buffer.reserve(buffer_size);
+  }
+
+  file_writer(const file_writer&) = delete;
+  file_writer& operator=(const file_writer&) = delete;
+
+  ~file_writer() {
+    if (closed) return;
+    if (std::uncaught_exceptions() > uncaught) {
+      if (temp.empty()) {
+        try {
+          flush();
+        } catch (const std::exception&) {
+          // Already unwinding: the original exception is the one to report.
+        }
+      }
+      discard();
+      return;
+    }
+    try {
+      close();
+    } catch (const std::exception& e) {
+      LOG(FATAL) << "file_writer: " << e.what();
+    }
+  }
+
   void write(const void* buf, size_t n) {
-    ofs.write((const char*) buf, n);
+    if (!deferred && buffer.size() + n > buffer_size) {
+      flush();
+      if (n > buffer_size) {
+        write_fully((const char*) buf, n);
+        return;
+      }
+    }
+    buffer.insert(buffer.end(), (const char*) buf, (const char*) buf + n);
   }
   void write(std::string_view sv) {
     write(sv.data(), sv.size());
   }
+  void put(char c) {
+    if (!deferred && buffer.size() == buffer_size) flush();
+    buffer.push_back(c);
+  }
   template<typename... Args>
   void print(Args&&... args) {
-    (ofs << ... << std::forward<Args>(args));
+    (print_one(args), ...);
   }
   void println() {
-    ofs << std::endl;
+    put('\n');
   }
   template<typename... Args>
   void println(Args&&... args) {
     print(std::forward<Args>(args)...);
-    ofs << std::endl;
+    put('\n');
+  }
+
+  // Hands the buffered output to the operating system.  A no-op in
+  // dvc::if_changed mode, where nothing is written before close().
+  void flush() {
+    if (deferred) return;
+    write_fully(buffer.data(), buffer.size());
+    buffer.clear();
   }
 
-  std::ostream& ostream() { return ofs; }
+  // Flushes and closes the file, renaming it into place in dvc::replace and
+  // dvc::if_changed modes.  The writer must not be used afterwards.  If this
+  // throws, the file is closed and any temporary file removed first.
+  void close() {
+    try {
+      if (deferred) {
+        if (unchanged()) {
+          closed = true;
+          return;
+        }
+        open_temp();
+        deferred = false;
+      }
+      flush();
+      int result = ::close(fd);
+      fd = -1;
+      if (result != 0) throw_file_error(path());
+      if (!temp.empty()) {
+        if (::rename(temp.c_str(), target.c_str()) != 0)
+          throw_file_error(target);
+        temp.clear();
+      }
+    } catch (...) {
+      discard();
+      throw;
+    }
+    closed = true;
+  }
+
+  // A stream onto the same buffer, for code that formats through iostreams.
+  std::ostream& ostream() { return stream; }
+
  private:
-  void open(const dvc::fspath& fspath, std::ios::openmode mode_extra) {
-    ofs.exceptions(std::ios::badbit | std::ios::failbit | std::ios::eofbit);
-    ofs.open(fspath.string().c_str(), std::ios::binary | std::ios::out | mode_extra);
+  class streambuf : public std::streambuf {
+   public:
+    streambuf(file_writer& w) : w(w) {}
+
+   protected:
+    int_type overflow(int_type c) override {
+      if (c != traits_type::eof()) w.put(traits_type::to_char_type(c));
+      return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+      w.write(s, n);
+      return n;
+    }
+
+   private:
+    file_writer& w;
+  };
+
+  template<typename T>
+  void print_one(const T& t) {
+    if constexpr (std::is_same_v<T, bool>) {
+      put(t ? '1' : '0');
+    } else if constexpr (std::is_same_v<T, char> ||
+                         std::is_same_v<T, signed char> ||
+                         std::is_same_v<T, unsigned char>) {
+      put(t);
+    } else if constexpr (std::is_integral_v<T>) {
+      char buf[24];
+      write(buf, std::to_chars(buf, buf + sizeof buf, t).ptr - buf);
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+      write(std::string_view(t));
+    } else {
+      stream << t;
+    }
+  }
+
+  // Creates a new file next to the target with mode 0666, so that the kernel
+  // applies the umask as for any other output.  mkstemp() creates files 0600,
+  // and the umask can only be read by setting it, which races with threads
+  // creating files meanwhile.
+  void open_temp() {
+    static std::atomic<unsigned> counter{0};
+    while (true) {
+      std::string name = target.string() + "." + std::to_string(::getpid()) +
+                         "." + std::to_string(counter++);
+      fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+      if (fd >= 0) {
+        temp = name;
+        return;
+      }
+      if (errno != EEXIST) throw_file_error(target);
+    }
+  }
+
+  // Whether the target already holds exactly the buffered output.
+  bool unchanged() const;
+
+  void open(const dvc::fspath& fspath, int flags) {
+    fd = ::open(fspath.string().c_str(),
+                O_WRONLY | O_CREAT | O_CLOEXEC | flags, 0666);
+    if (fd < 0) throw_file_error(fspath);
+    target = fspath;
+    buffer.reserve(buffer_size);
+  }
+
+  void write_fully(const char* p, size_t n) {
+    while (n != 0) {
+      ssize_t written = ::write(fd, p, n);
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        throw_file_error(path());
+      }
+      p += written;
+      n -= written;
+    }
   }
-  std::ofstream ofs;
+
+  void discard() {
+    closed = true;
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    if (!temp.empty()) ::unlink(temp.c_str());
+  }
+
+  const dvc::fspath& path() const { return temp.empty() ? target : temp; }
+
+  int fd = -1;
+  dvc::fspath target;
+  dvc::fspath temp;
+  bool deferred = false;
+  bool closed = false;
+  // Exceptions in flight when the writer was made.  The writer is destroyed
+  // by unwinding only if there are more, not merely because it lives in a
+  // destructor that runs during unwinding.
+  int uncaught = std::uncaught_exceptions();
+  std::vector<char> buffer;
+  streambuf sbuf{*this};
+  std::ostream stream{&sbuf};
 };
 
+// A read-only, private memory mapping of a whole file.  The pages are
+// populated up front and the kernel is told they will be read sequentially.
+class mapped_file {
+ public:
+  mapped_file(const dvc::fspath& fspath) {
+    int fd = ::open(fspath.string().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw_file_error(fspath);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw_file_error(fspath);
+    }
+    size_ = st.st_size;
+    if (size_ != 0) {
+      int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+      flags |= MAP_POPULATE;
+#endif
+      void* addr = ::mmap(nullptr, size_, PROT_READ, flags, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        throw_file_error(fspath);
+      }
+      data_ = static_cast<const char*>(addr);
+      ::madvise(addr, size_, MADV_SEQUENTIAL);
+      ::madvise(addr, size_, MADV_WILLNEED);
+    }
+    ::close(fd);
+  }
+
+  mapped_file(mapped_file&& that) : data_(that.data_), size_(that.size_) {
+    that.data_ = nullptr;
+    that.size_ = 0;
+  }
+
+  mapped_file& operator=(mapped_file&& that) {
+    std::swap(data_, that.data_);
+    std::swap(size_, that.size_);
+    return *this;
+  }
+
+  ~mapped_file() {
+    if (data_) ::munmap(const_cast<char*>(data_), size_);
+  }
+
+  const char* data() const { return data_ ? data_ : ""; }
+  size_t size() const { return size_; }
+
+  std::string_view view() const { return {data(), size()}; }
+  operator std::string_view() const { return view(); }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+inline bool file_writer::unchanged() const {
+  std::error_code ec;
+  if (std::experimental::filesystem::file_size(target, ec) != buffer.size())
+    return false;
+  return mapped_file(target).view() ==
+         std::string_view(buffer.data(), buffer.size());
+}
+
+struct mapped_t {};
+inline constexpr mapped_t mapped{};
+
 inline std::string load_file(const fspath& filename) {
-  file_reader reader(filename);
   std::string s;
-  s.resize(reader.size());
+  s.resize(std::experimental::filesystem::file_size(filename));
+  file_reader reader(filename);
   reader.read(&s[0], s.size());
   return s;
 }
 
+inline mapped_file load_file(const fspath& filename, mapped_t) {
+  return mapped_file(filename);
+}
+
 inline void touch_file(const dvc::fspath& fspath) {
   file_writer writer(fspath, append);
 }
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "core/container.h"
+
+namespace dvc {
+
+// A string stored once in a process-wide pool.  Interned strings are a
+// single pointer; two compare equal iff they point at the same pool entry,
+// and hashing returns a hash computed when the string was first interned.
+// Pool entries live until the process exits.
+class interned_string {
+  template<typename T>
+  using enable_if_string_t =
+      std::enable_if_t<!std::is_same_v<T, interned_string> &&
+                       std::is_convertible_v<const T&, std::string_view>>;
+
+ public:
+  interned_string() : e(&empty_entry()) {}
+  interned_string(std::string_view s) : e(intern(s)) {}
+  interned_string(const std::string& s) : e(intern(s)) {}
+  interned_string(const char* s) : e(intern(s)) {}
+
+  const std::string& str() const { return e->str; }
+  std::string_view view() const { return e->str; }
+  const char* c_str() const { return e->str.c_str(); }
+  size_t size() const { return e->str.size(); }
+  bool empty() const { return e->str.empty(); }
+  size_t hash() const { return e->hash; }
+
+  // The string as an integer, for containers that keep values in untyped
+  // slots.  from_bits(s.bits()) == s.
+  uintptr_t bits() const { return reinterpret_cast<uintptr_t>(e); }
+  static interned_string from_bits(uintptr_t bits) {
+    interned_string s;
+    s.e = reinterpret_cast<const entry*>(bits);
+    return s;
+  }
+
+  operator const std::string&() const { return e->str; }
+  operator std::string_view() const { return e->str; }
+
+  friend bool operator==(interned_string a, interned_string b) {
+    return a.e == b.e;
+  }
+  friend bool operator!=(interned_string a, interned_string b) {
+    return a.e != b.e;
+  }
+  // Orders by contents, so that sorted output does not depend on where
+  // entries were allocated.
+  friend bool operator<(interned_string a, interned_string b) {
+    return a.e != b.e && a.e->str < b.e->str;
+  }
+
+  // Comparisons with uninterned strings compare contents.
+  template<typename T, typename = enable_if_string_t<T>>
+  friend bool operator==(interned_string a, const T& b) {
+    return a.view() == std::string_view(b);
+  }
+  template<typename T, typename = enable_if_string_t<T>>
+  friend bool operator==(const T& a, interned_string b) {
+    return std::string_view(a) == b.view();
+  }
+  template<typename T, typename = enable_if_string_t<T>>
+  friend bool operator!=(interned_string a, const T& b) {
+    return !(a == b);
+  }
+  template<typename T, typename = enable_if_string_t<T>>
+  friend bool operator!=(const T& a, interned_string b) {
+    return !(a == b);
+  }
+
+  friend std::ostream& operator<<(std::ostream& o, interned_string s) {
+    return o << s.view();
+  }
+
+ private:
+  struct entry {
+    std::string str;
+    size_t hash;
+  };
+
+  static constexpr size_t num_shards = 16;
+
+  // Entries are spread over independently locked shards by hash, so that
+  // concurrent parsers rarely contend.
+  struct shard {
+    std::mutex mutex;
+    std::deque<entry> entries;
+    dvc::dense_hash_map<std::string_view, const entry*> index;
+  };
+
+  static const entry& empty_entry() {
+    static const entry empty{"", std::hash<std::string_view>()("")};
+    return empty;
+  }
+
+  static shard* shards() {
+    static shard* pool = new shard[num_shards];
+    return pool;
+  }
+
+  static const entry* intern(std::string_view s) {
+    if (s.empty()) return &empty_entry();
+    size_t hash = std::hash<std::string_view>()(s);
+    shard& sh = shards()[hash % num_shards];
+    std::lock_guard<std::mutex> lock(sh.mutex);
+    auto it = sh.index.find_hashed(hash, s);
+    if (it != sh.index.end()) return it->second;
+    // The entry is published only once it exists, keyed by its own copy of
+    // s, so that a failed allocation leaves the index as it was.
+    const entry* e = &sh.entries.emplace_back(entry{std::string(s), hash});
+    sh.index.try_emplace_hashed(hash, e->str, e);
+    return e;
+  }
+
+  const entry* e;
+};
+
+}  // namespace dvc
+
+namespace std {
+
+template<>
+struct hash<dvc::interned_string> {
+  size_t operator()(dvc::interned_string s) const { return s.hash(); }
+};
+
+}  // namespace std
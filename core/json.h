@@ -1,58 +1,493 @@
 #pragma once
 
-#include <memory>
-#include <rapidjson/ostreamwrapper.h>
-#include <rapidjson/writer.h>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
 #include <glog/logging.h>
 
+#include "core/file.h"
+#include "core/scanner.h"
+#include "core/string.h"
+
 namespace dvc {
 
+// Streaming JSON writer.  Output is formatted into a contiguous buffer; with a
+// dvc::file_writer or std::ostream sink the buffer is drained into the sink
+// whenever it grows past drain_size and on flush() or destruction, otherwise
+// it accumulates and is available from str().
+//
+// Misuse (a key outside an object, unbalanced ends) is only checked in debug
+// builds.
 class json_writer {
  public:
-  json_writer(std::ostream& o) : ostream_wrapper(std::make_unique<rapidjson::OStreamWrapper>(o)), writer(*ostream_wrapper) {
+  static constexpr size_t drain_size = 1 << 16;
+
+  explicit json_writer(bool pretty = false) : pretty(pretty) {}
+
+  explicit json_writer(dvc::file_writer& file, bool pretty = false)
+      : pretty(pretty), file(&file) {
+    out.reserve(2 * drain_size);
+  }
 
+  explicit json_writer(std::ostream& o, bool pretty = false)
+      : pretty(pretty), stream(&o) {
+    out.reserve(2 * drain_size);
   }
 
+  json_writer(const json_writer&) = delete;
+  json_writer& operator=(const json_writer&) = delete;
+
+  ~json_writer() { flush(); }
+
   void write_null() {
-    CHECK(writer.Null());
+    begin_value();
+    out += "null";
   }
 
   void write_bool(bool b) {
-    CHECK(writer.Bool(b));
+    begin_value();
+    out += (b ? "true" : "false");
   }
 
+  // Writes d as rapidjson::Writer does: the shortest digits that read back
+  // as d, in fixed notation while the decimal point is within 21 digits,
+  // with a trailing .0 on integers, and otherwise as 1.5e30 or 1e-7.  JSON
+  // has no NaN or infinities.
   void write_number(double d) {
-    CHECK(writer.Double(d));
+    CHECK(std::isfinite(d)) << "non-finite JSON number " << d;
+    begin_value();
+    char buf[32];
+    char* end =
+        std::to_chars(buf, buf + sizeof buf, d, std::chars_format::scientific)
+            .ptr;
+    std::string_view sv(buf, end - buf);
+    if (sv[0] == '-') {
+      out += '-';
+      sv.remove_prefix(1);
+    }
+    // sv is d.ddde+XX: collect the digits and the exponent.
+    size_t e = sv.find('e');
+    char digits[24];
+    int length = 0;
+    for (char c : sv.substr(0, e))
+      if (c != '.') digits[length++] = c;
+    int exponent = 0;
+    for (char c : sv.substr(e + 2)) exponent = exponent * 10 + (c - '0');
+    if (sv[e + 1] == '-') exponent = -exponent;
+
+    // The value is 0.digits * 10^point.
+    int point = exponent + 1;
+    std::string_view all(digits, length);
+    if (length <= point && point <= 21) {
+      out += all;
+      out.append(point - length, '0');
+      out += ".0";
+    } else if (0 < point && point <= 21) {
+      out += all.substr(0, point);
+      out += '.';
+      out += all.substr(point);
+    } else if (-6 < point && point <= 0) {
+      out += "0.";
+      out.append(-point, '0');
+      out += all;
+    } else {
+      out += digits[0];
+      if (length > 1) {
+        out += '.';
+        out += all.substr(1);
+      }
+      out += 'e';
+      char* exponent_end =
+          std::to_chars(buf, buf + sizeof buf, point - 1).ptr;
+      out.append(buf, exponent_end - buf);
+    }
   }
 
   void write_string(std::string_view sv) {
-    CHECK(writer.String(sv.data(), sv.size()));
+    begin_value();
+    write_quoted(sv);
   }
 
   void write_key(std::string_view sv) {
-    CHECK(writer.Key(sv.data(), sv.size()));
+    DCHECK(!levels.empty() && levels.back().object && !after_key)
+        << "key outside object";
+    begin_element();
+    write_quoted(sv);
+    out += (pretty ? ": " : ":");
+    after_key = true;
+  }
+
+  // Writes `json`, which must be a complete JSON value, verbatim.
+  void write_raw(std::string_view json) {
+    begin_value();
+    out += json;
+  }
+
+  void start_object() { start('{', true); }
+
+  void end_object() { end('}', true); }
+
+  void start_array() { start('[', false); }
+
+  void end_array() { end(']', false); }
+
+  // Drains buffered output into the sink, if there is one.
+  void flush() {
+    if (file)
+      file->write(out);
+    else if (stream)
+      stream->write(out.data(), out.size());
+    else
+      return;
+    out.clear();
+  }
+
+  // The output so far, when writing without a sink.
+  std::string_view str() const { return out; }
+
+ private:
+  struct level {
+    bool object;
+    size_t count;
+  };
+
+  void begin_value() {
+    if (after_key) {
+      after_key = false;
+    } else {
+      DCHECK(levels.empty() || !levels.back().object) << "value without key";
+      if (!levels.empty()) begin_element();
+    }
+    if (out.size() >= drain_size) flush();
+  }
+
+  void begin_element() {
+    level& l = levels.back();
+    if (l.count++ != 0) out += ',';
+    if (pretty) newline(levels.size());
+  }
+
+  void start(char c, bool object) {
+    begin_value();
+    out += c;
+    levels.push_back({object, 0});
   }
 
-  void start_object() {
-    CHECK(writer.StartObject());
+  void end(char c, bool object) {
+    DCHECK(!levels.empty() && levels.back().object == object && !after_key)
+        << "unbalanced " << c;
+    bool empty = levels.back().count == 0;
+    levels.pop_back();
+    if (pretty && !empty) newline(levels.size());
+    out += c;
   }
 
-  void end_object() {
-    CHECK(writer.EndObject());
+  void newline(size_t depth) {
+    out += '\n';
+    out.append(4 * depth, ' ');
   }
 
-  void start_array() {
-    CHECK(writer.StartArray());
+  void write_quoted(std::string_view sv) {
+    static constexpr char hex[] = "0123456789ABCDEF";
+    out += '"';
+    size_t run = 0;
+    for (size_t i = 0; i < sv.size(); i++) {
+      unsigned char c = sv[i];
+      if (c >= 0x20 && c != '"' && c != '\\') continue;
+      out.append(sv.data() + run, i - run);
+      run = i + 1;
+      out += '\\';
+      switch (c) {
+        case '"':
+        case '\\':
+          out += char(c);
+          break;
+        case '\b':
+          out += 'b';
+          break;
+        case '\f':
+          out += 'f';
+          break;
+        case '\n':
+          out += 'n';
+          break;
+        case '\r':
+          out += 'r';
+          break;
+        case '\t':
+          out += 't';
+          break;
+        default:
+          out += "u00";
+          out += hex[c >> 4];
+          out += hex[c & 0xF];
+      }
+    }
+    out.append(sv.data() + run, sv.size() - run);
+    out += '"';
   }
 
-  void end_array() {
-    CHECK(writer.EndArray());
+  bool pretty;
+  dvc::file_writer* file = nullptr;
+  std::ostream* stream = nullptr;
+  std::string out;
+  std::vector<level> levels;
+  bool after_key = false;
+};
+
+// Streaming pull reader for JSON text.  Values are consumed in document
+// order: the caller asks for the value it expects next (or peek()s at its
+// kind), iterates objects with next_key() and arrays with next_element(), and
+// skip_value()s anything it does not care about.  Nothing is materialised
+// beyond the value being read.
+//
+// Strings are returned as views into the input when they contain no escapes;
+// otherwise they are decoded into a scratch buffer and the view is valid only
+// until the next string is read.  Malformed input is fatal.
+class json_reader {
+ public:
+  enum class kind { NULL_, BOOL, NUMBER, STRING, OBJECT, ARRAY };
+
+  json_reader(const std::string& filename, std::string_view json)
+      : filename(filename), s(filename, json, dvc::borrow) {}
+
+  kind peek() {
+    skip_whitespace();
+    switch (s.peek()) {
+      case 'n':
+        return kind::NULL_;
+      case 't':
+      case 'f':
+        return kind::BOOL;
+      case '"':
+        return kind::STRING;
+      case '{':
+        return kind::OBJECT;
+      case '[':
+        return kind::ARRAY;
+      default:
+        if (s.peek() == '-' || (s.peek() >= '0' && s.peek() <= '9'))
+          return kind::NUMBER;
+        fail("value");
+    }
+  }
+
+  void read_null() {
+    skip_whitespace();
+    expect_literal("null");
+  }
+
+  bool read_bool() {
+    skip_whitespace();
+    if (s.peek() == 't') {
+      expect_literal("true");
+      return true;
+    }
+    expect_literal("false");
+    return false;
+  }
+
+  double read_number() {
+    skip_whitespace();
+    std::string_view rest = s.get_data().substr(s.pos());
+    double d;
+    auto result = std::from_chars(rest.data(), rest.data() + rest.size(), d);
+    if (result.ec != std::errc()) fail("number");
+    s.incr(result.ptr - rest.data());
+    return d;
+  }
+
+  // Reads a number that must be an integer in the range of int64_t.
+  int64_t read_integer() {
+    skip_whitespace();
+    std::string_view rest = s.get_data().substr(s.pos());
+    int64_t i;
+    auto result = std::from_chars(rest.data(), rest.data() + rest.size(), i);
+    if (result.ec != std::errc() ||
+        (result.ptr != rest.data() + rest.size() &&
+         (*result.ptr == '.' || *result.ptr == 'e' || *result.ptr == 'E')))
+      fail("integer");
+    s.incr(result.ptr - rest.data());
+    return i;
+  }
+
+  std::string_view read_string() { return read_string(scratch); }
+
+  void start_object() { start('{'); }
+
+  // Reads the next key of the current object, or consumes the closing brace
+  // and returns false.
+  bool next_key(std::string_view& key) {
+    if (!next('}')) return false;
+    key = read_string(key_scratch);
+    skip_whitespace();
+    expect(':');
+    return true;
+  }
+
+  void start_array() { start('['); }
+
+  // Positions the reader at the next element of the current array, or
+  // consumes the closing bracket and returns false.
+  bool next_element() { return next(']'); }
+
+  void skip_value() {
+    switch (peek()) {
+      case kind::NULL_:
+        read_null();
+        break;
+      case kind::BOOL:
+        read_bool();
+        break;
+      case kind::NUMBER:
+        read_number();
+        break;
+      case kind::STRING:
+        read_string();
+        break;
+      case kind::OBJECT: {
+        start_object();
+        std::string_view key;
+        while (next_key(key)) skip_value();
+        break;
+      }
+      case kind::ARRAY:
+        start_array();
+        while (next_element()) skip_value();
+        break;
+    }
+  }
+
+  // Checks that only whitespace remains.
+  void end() {
+    skip_whitespace();
+    if (s.peek() != dvc::scanner::eof) fail("end of input");
   }
 
  private:
-  std::unique_ptr<rapidjson::OStreamWrapper> ostream_wrapper;
-  rapidjson::Writer<rapidjson::OStreamWrapper> writer;
+  void skip_whitespace() { s.skip_while(dvc::whitespace); }
+
+  [[noreturn]] void fail(std::string_view expected) {
+    LOG(FATAL) << filename << ":" << s.line() + 1 << ": expected " << expected
+               << " at offset " << s.pos();
+    abort();
+  }
+
+  void expect(char c) {
+    if (s.peek() != c) fail(std::string_view(&c, 1));
+    s.incr();
+  }
+
+  void expect_literal(std::string_view literal) {
+    if (s.get_data().substr(s.pos(), literal.size()) != literal)
+      fail(literal);
+    s.incr(literal.size());
+  }
+
+  void start(char c) {
+    skip_whitespace();
+    expect(c);
+    first.push_back(true);
+  }
+
+  bool next(char close) {
+    skip_whitespace();
+    if (s.peek() == close) {
+      s.incr();
+      first.pop_back();
+      return false;
+    }
+    if (first.back())
+      first.back() = false;
+    else
+      expect(',');
+    return true;
+  }
+
+  std::string_view read_string(std::string& buffer) {
+    static constexpr dvc::byte_class special{
+        {'"', '"'}, {'\\', '\\'}, {'\0', '\x1F'}};
+    skip_whitespace();
+    expect('"');
+    size_t begin = s.pos();
+    s.skip_until(special);
+    if (s.peek() == '"') {
+      std::string_view result = s.substr(begin, s.pos() - begin);
+      s.incr();
+      return result;
+    }
+    buffer.assign(s.get_data().substr(begin, s.pos() - begin));
+    while (true) {
+      char c = s.peek();
+      if (c == '"') break;
+      if (c != '\\') fail("string character");
+      s.incr();
+      c = s.pop();
+      switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+          buffer += c;
+          break;
+        case 'b':
+          buffer += '\b';
+          break;
+        case 'f':
+          buffer += '\f';
+          break;
+        case 'n':
+          buffer += '\n';
+          break;
+        case 'r':
+          buffer += '\r';
+          break;
+        case 't':
+          buffer += '\t';
+          break;
+        case 'u':
+          dvc::append_utf8(buffer, read_code_point());
+          break;
+        default:
+          fail("escape");
+      }
+      begin = s.pos();
+      s.skip_until(special);
+      buffer.append(s.get_data().substr(begin, s.pos() - begin));
+    }
+    s.incr();
+    return buffer;
+  }
+
+  uint32_t read_hex4() {
+    std::string_view digits = s.get_data().substr(s.pos(), 4);
+    uint32_t u = 0;
+    auto result =
+        std::from_chars(digits.data(), digits.data() + digits.size(), u, 16);
+    if (digits.size() != 4 || result.ptr != digits.data() + 4) fail("\\uXXXX");
+    s.incr(4);
+    return u;
+  }
+
+  uint32_t read_code_point() {
+    uint32_t u = read_hex4();
+    if (u >= 0xD800 && u < 0xDC00) {
+      expect_literal("\\u");
+      uint32_t low = read_hex4();
+      if (low < 0xDC00 || low >= 0xE000) fail("low surrogate");
+      u = 0x10000 + ((u - 0xD800) << 10) + (low - 0xDC00);
+    }
+    return u;
+  }
 
+  std::string filename;
+  dvc::scanner s;
+  std::vector<bool> first;
+  std::string scratch;
+  std::string key_scratch;
 };
 
 }  // namespace dvc
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string_view>
+
+namespace dvc {
+
+template<typename Kind>
+struct keyword {
+  std::string_view spelling;
+  Kind kind;
+};
+
+// A fixed set of keywords laid out at compile time in a collision free
+// (perfect) hash table.  A lookup hashes the length and three characters of
+// the candidate, then does a single comparison against one slot.
+template<typename Kind, size_t N>
+class keyword_table {
+ public:
+  static constexpr size_t num_slots = [] {
+    size_t n = 2;
+    while (n < 2 * N) n *= 2;
+    return n;
+  }();
+
+  constexpr keyword_table(const keyword<Kind> (&keywords)[N]) {
+    for (seed = 1; seed < max_seed; seed++) {
+      if (try_seed(keywords)) return;
+    }
+    throw "keyword_table: no perfect hash found";
+  }
+
+  constexpr std::optional<Kind> find(std::string_view spelling) const {
+    if (spelling.empty()) return std::nullopt;
+    const keyword<Kind>& slot = slots[hash(spelling, seed)];
+    if (slot.spelling == spelling) return slot.kind;
+    return std::nullopt;
+  }
+
+ private:
+  static constexpr uint32_t max_seed = 1 << 16;
+
+  static constexpr size_t hash(std::string_view s, uint32_t seed) {
+    uint32_t h = uint32_t(s.size()) * 0x9E3779B1u;
+    h ^= uint8_t(s.front()) * seed;
+    h ^= uint8_t(s[s.size() / 2]) * (seed * 0x85EBCA6Bu + 1);
+    h ^= uint8_t(s.back()) * (seed * 0xC2B2AE35u + 3);
+    h ^= h >> 15;
+    return h & (num_slots - 1);
+  }
+
+  constexpr bool try_seed(const keyword<Kind> (&keywords)[N]) {
+    slots = {};
+    for (const keyword<Kind>& k : keywords) {
+      keyword<Kind>& slot = slots[hash(k.spelling, seed)];
+      if (!slot.spelling.empty()) return false;
+      slot = k;
+    }
+    return true;
+  }
+
+  std::array<keyword<Kind>, num_slots> slots = {};
+  uint32_t seed = 0;
+};
+
+template<typename Kind, size_t N>
+constexpr keyword_table<Kind, N> make_keyword_table(
+    const keyword<Kind> (&keywords)[N]) {
+  return keyword_table<Kind, N>(keywords);
+}
+
+// A 256-entry table classifying single characters, e.g. punctuation.
+template<typename Kind>
+class char_table {
+ public:
+  struct entry {
+    char c;
+    Kind kind;
+  };
+
+  constexpr char_table(std::initializer_list<entry> entries) {
+    for (entry e : entries) {
+      kinds[uint8_t(e.c)] = e.kind;
+      present[uint8_t(e.c)] = true;
+    }
+  }
+
+  constexpr std::optional<Kind> find(char c) const {
+    if (!present[uint8_t(c)]) return std::nullopt;
+    return kinds[uint8_t(c)];
+  }
+
+ private:
+  std::array<Kind, 256> kinds = {};
+  std::array<bool, 256> present = {};
+};
+
+}  // namespace dvc
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <optional>
 #include <string>
 #include <vector>
 #include <glog/logging.h>
@@ -38,4 +40,45 @@ class parser {
   size_t pos_ = 0;
 };
 
+// Parser that pulls tokens from a scanner on demand instead of taking the
+// whole token stream up front.  Only the last `lookahead` tokens are kept, so
+// peek(offset) is limited to offset < lookahead.  Scanner::parse_next_token()
+// must keep returning the end token once the input is exhausted.
+template<class Token, class Scanner, size_t lookahead>
+class stream_parser {
+ public:
+  stream_parser(const std::string& filename, Scanner& scanner) : filename(filename), scanner(scanner) {
+
+  }
+
+  const Token& peek(size_t offset = 0) {
+    CHECK_LT(offset, lookahead) << "lookahead exceeded in " << filename;
+    size_t index = pos() + offset;
+    while (pulled <= index) {
+      window[pulled % lookahead] = scanner.parse_next_token();
+      pulled++;
+    }
+    return *window[index % lookahead];
+  }
+
+  Token pop() {
+    Token token = peek();
+    incr();
+    return token;
+  }
+
+  size_t pos() const { return pos_; }
+
+  void incr(size_t offset = 1) {
+    pos_ += offset;
+  }
+
+ private:
+  std::string filename;
+  Scanner& scanner;
+  std::array<std::optional<Token>, lookahead> window;
+  size_t pulled = 0;
+  size_t pos_ = 0;
+};
+
 }  // namespace dvc
@@ -1,26 +1,56 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <glog/logging.h>
 
+#include "core/bytescan.h"
+
 namespace dvc {
 
+struct borrow_t {};
+inline constexpr borrow_t borrow{};
+
+// Whitespace as classified by std::isspace in the "C" locale.
+inline constexpr byte_class whitespace{{'\t', '\r'}, {' ', ' '}};
+
+// Character scanner over an input buffer.  The buffer is either owned by the
+// scanner or, when constructed with dvc::borrow, borrowed from the caller, who
+// must keep it alive for as long as the scanner and any views it returned.
+//
+// Line numbers are not tracked while scanning.  The first call to line()
+// indexes the newlines of the whole input, and line() then binary searches
+// that index for the current position.
 class scanner {
  public:
-  scanner(const std::string& filename, std::string data) : filename(filename), data(std::move(data)) {
+  scanner(const std::string& filename, std::string data)
+      : filename(filename), storage(std::move(data)), data(storage) {}
 
-  }
+  scanner(const std::string& filename, std::string_view data, borrow_t)
+      : filename(filename), data(data) {}
+
+  scanner(const scanner&) = delete;
+  scanner& operator=(const scanner&) = delete;
 
   static constexpr char eof = 0;
 
   char peek(size_t offset = 0) const {
-    if (pos() + offset > data.size())
+    if (pos() + offset >= data.size())
       return 0;
     else
       return data[pos() + offset];
   }
 
-  size_t line() const { return line_; }
+  size_t line() const { return line(pos_); }
+
+  // The zero-based line of offset pos.
+  size_t line(size_t pos) const {
+    if (!newlines_indexed) index_newlines();
+    return std::lower_bound(newlines.begin(), newlines.end(), pos) -
+           newlines.begin();
+  }
 
   char pop() {
     char c = peek();
@@ -32,18 +62,52 @@ class scanner {
   void pos(size_t pos) { this->pos_ = pos; }
 
   void incr(size_t offset = 1) {
-    if (peek() == '\n') line_++;
     pos_ += offset;
     CHECK_LE(pos(), data.size()) << "unexpected end of file " << filename;
   }
 
-  const std::string& get_data() const { return data; }
+  // Advances past a run of bytes in cls.
+  void skip_while(const byte_class& cls) {
+    advance_to(bytescan::skip_while(cur(), end(), cls));
+  }
+
+  // Advances to the next byte in cls, or to the end of input.
+  void skip_until(const byte_class& cls) {
+    advance_to(bytescan::find_first_of(cur(), end(), cls));
+  }
+
+  size_t count_newlines(size_t begin, size_t end) const {
+    return bytescan::count(data.data() + begin, data.data() + end, '\n');
+  }
+
+  // A view of the input, valid as long as the input buffer is.
+  std::string_view substr(size_t pos, size_t n) const {
+    return data.substr(pos, n);
+  }
+
+  std::string_view get_data() const { return data; }
 
  private:
+  const char* cur() const { return data.data() + pos_; }
+  const char* end() const { return data.data() + data.size(); }
+
+  void advance_to(const char* p) { pos_ = p - data.data(); }
+
+  void index_newlines() const {
+    static constexpr byte_class newline{{'\n', '\n'}};
+    newlines.reserve(count_newlines(0, data.size()));
+    for (const char* p = bytescan::find_first_of(data.data(), end(), newline);
+         p != end(); p = bytescan::find_first_of(p + 1, end(), newline))
+      newlines.push_back(p - data.data());
+    newlines_indexed = true;
+  }
+
   std::string filename;
-  const std::string data;
+  const std::string storage;
+  const std::string_view data;
   size_t pos_ = 0;
-  size_t line_ = 0;
+  mutable std::vector<size_t> newlines;
+  mutable bool newlines_indexed = false;
 };
 
 }  // namespace dvc
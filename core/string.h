@@ -1,23 +1,118 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <glog/logging.h>
 
 namespace dvc {
 
-inline std::vector<std::string> split(const std::string& sep,
-                               const std::string joined) {
-  std::vector<std::string> result;
-  size_t pos = 0;
-  while (true) {
-    size_t next_pos = joined.find(sep, pos);
-    if (next_pos == std::string::npos) {
-      result.push_back(joined.substr(pos));
-      return result;
+// Lazily splits `joined` on `sep`, yielding views into `joined`.  Like
+// split, n separators yield n + 1 pieces, some of which may be empty.
+class split_view {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = std::string_view;
+
+    std::string_view operator*() const {
+      return view->joined.substr(pos, next == npos ? npos : next - pos);
+    }
+
+    iterator& operator++() {
+      if (next == npos) {
+        pos = npos;
+      } else {
+        pos = next + view->sep.size();
+        next = view->find(pos);
+      }
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const iterator& that) const { return pos == that.pos; }
+    bool operator!=(const iterator& that) const { return pos != that.pos; }
+
+   private:
+    friend class split_view;
+
+    iterator(const split_view* view, size_t pos)
+        : view(view), pos(pos), next(pos == npos ? npos : view->find(pos)) {}
+
+    const split_view* view;
+    size_t pos;
+    size_t next;
+  };
+
+  split_view(std::string_view sep, std::string_view joined)
+      : sep(sep), joined(joined) {
+    DCHECK(!sep.empty());
+  }
+
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, npos); }
+
+ private:
+  static constexpr size_t npos = std::string_view::npos;
+
+  // Offset of the first separator at or after pos.
+  size_t find(size_t pos) const {
+    if (pos >= joined.size()) return npos;
+    const char* first = joined.data();
+    const char* last = first + joined.size();
+    const char* p = first + pos;
+    while (true) {
+      p = static_cast<const char*>(std::memchr(p, sep[0], last - p));
+      if (p == nullptr || size_t(last - p) < sep.size()) return npos;
+      if (sep.size() == 1 ||
+          std::memcmp(p + 1, sep.data() + 1, sep.size() - 1) == 0)
+        return p - first;
+      p++;
     }
-    result.push_back(joined.substr(pos, next_pos - pos));
-    pos = next_pos + sep.size();
   }
+
+  std::string_view sep;
+  std::string_view joined;
+};
+
+// Appends the UTF-8 encoding of code point u.
+inline void append_utf8(std::string& buffer, uint32_t u) {
+  if (u < 0x80) {
+    buffer += char(u);
+  } else if (u < 0x800) {
+    buffer += char(0xC0 | (u >> 6));
+    buffer += char(0x80 | (u & 0x3F));
+  } else if (u < 0x10000) {
+    buffer += char(0xE0 | (u >> 12));
+    buffer += char(0x80 | ((u >> 6) & 0x3F));
+    buffer += char(0x80 | (u & 0x3F));
+  } else {
+    buffer += char(0xF0 | (u >> 18));
+    buffer += char(0x80 | ((u >> 12) & 0x3F));
+    buffer += char(0x80 | ((u >> 6) & 0x3F));
+    buffer += char(0x80 | (u & 0x3F));
+  }
+}
+
+inline std::vector<std::string> split(std::string_view sep,
+                                      std::string_view joined) {
+  std::vector<std::string> result;
+  for (std::string_view piece : split_view(sep, joined))
+    result.emplace_back(piece);
+  return result;
 }
 
 }  // namespace dvc
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dvc {
+
+// A fixed set of worker threads running submitted tasks in order of
+// submission.  Destroying the pool finishes the queued tasks first.
+class thread_pool {
+ public:
+  explicit thread_pool(
+      size_t num_threads = std::max(1u, std::thread::hardware_concurrency())) {
+    for (size_t i = 0; i < num_threads; i++)
+      workers.emplace_back([this] { work(); });
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    task_ready.notify_all();
+    for (std::thread& worker : workers) worker.join();
+  }
+
+  size_t size() const { return workers.size(); }
+
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(std::move(task));
+      unfinished++;
+    }
+    task_ready.notify_one();
+  }
+
+  // Blocks until every submitted task has finished.
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    all_done.wait(lock, [this] { return unfinished == 0; });
+  }
+
+  // Calls f(i) for each i in [0, n) on the workers, handing out indices in
+  // increasing order, and waits for all calls to finish.
+  template<typename F>
+  void parallel_for(size_t n, F f) {
+    std::atomic<size_t> next{0};
+    for (size_t w = 0; w < std::min(n, size()); w++)
+      submit([&] {
+        for (size_t i = next++; i < n; i = next++) f(i);
+      });
+    wait();
+  }
+
+ private:
+  void work() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        task_ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--unfinished == 0) all_done.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable task_ready;
+  std::condition_variable all_done;
+  std::deque<std::function<void()>> tasks;
+  size_t unfinished = 0;
+  bool stopping = false;
+  std::vector<std::thread> workers;
+};
+
+}  // namespace dvc
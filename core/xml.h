@@ -0,0 +1,374 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glog/logging.h>
+
+#include "core/scanner.h"
+#include "core/string.h"
+
+namespace dvc {
+
+// A streaming pull parser for XML, reading a borrowed buffer (typically a
+// mapped file) without building a document tree.  Non-validating: the prolog,
+// doctype and comments are skipped, and only the predefined and numeric
+// character references are decoded.  Text is reported as tinyxml2 does:
+// runs of only whitespace are dropped, other runs are kept verbatim, and
+// comments split runs.
+//
+// Names, attributes and text are views that are valid until the next call to
+// next().
+class xml_reader {
+ public:
+  enum event { START_ELEMENT, END_ELEMENT, TEXT, END_DOCUMENT };
+
+  struct attribute {
+    std::string_view name;
+    std::string_view value;
+  };
+
+  // Reads xml from offset pos, which must be the start of markup; the
+  // element starting there is read as if it were at the top level.
+  xml_reader(const std::string& filename, std::string_view xml, size_t pos = 0)
+      : filename(filename), s(filename, xml, dvc::borrow) {
+    s.pos(pos);
+  }
+
+  // Advances to the next event.  An empty element tag yields a START_ELEMENT
+  // and an END_ELEMENT.
+  event next() {
+    if (pending_end) {
+      pending_end = false;
+      close();
+      return END_ELEMENT;
+    }
+    while (true) {
+      event_pos = s.pos();
+      if (s.pos() == s.get_data().size()) {
+        if (!open.empty()) fail("</" + std::string(open.back()) + ">");
+        return END_DOCUMENT;
+      }
+      if (s.peek() != '<') {
+        if (read_text()) return TEXT;
+      } else if (starts_with("<?")) {
+        skip_past("?>");
+      } else if (starts_with("<!--")) {
+        skip_past("-->");
+      } else if (starts_with("<![CDATA[")) {
+        s.incr(9);
+        size_t begin = s.pos();
+        skip_past("]]>");
+        set_text(s.substr(begin, s.pos() - 3 - begin));
+        return TEXT;
+      } else if (starts_with("<!")) {
+        skip_doctype();
+      } else if (starts_with("</")) {
+        read_end_tag();
+        return END_ELEMENT;
+      } else {
+        read_start_tag();
+        return START_ELEMENT;
+      }
+    }
+  }
+
+  // The element of a START_ELEMENT or END_ELEMENT.
+  std::string_view name() const { return name_; }
+
+  // The attributes of a START_ELEMENT, in document order.
+  const std::vector<attribute>& attributes() const { return attributes_; }
+
+  // The text of a TEXT event.
+  std::string_view text() const { return text_; }
+
+  // The offset in the input the current event starts at.
+  size_t offset() const { return event_pos; }
+
+  // The one-based line the current event starts on.
+  size_t line() const { return s.line(event_pos) + 1; }
+
+  // The number of open elements.
+  size_t depth() const { return open.size(); }
+
+  // Consumes events until the element open at depth d has been closed.
+  void skip_to_end(size_t d) {
+    while (depth() >= d) next();
+  }
+
+  // Consumes the rest of the element just started.  Unless text is being
+  // captured, the markup is only scanned for tags rather than parsed, so the
+  // skipped content is not checked to be well-formed.
+  void skip_element() {
+    static constexpr byte_class lt{{'<', '<'}};
+    static constexpr byte_class tag_end{{'"', '"'}, {'\'', '\''}, {'>', '>'}};
+    if (pending_end || !captures.empty()) {
+      skip_to_end(depth());
+      return;
+    }
+    for (size_t d = 1; d > 0;) {
+      s.skip_until(lt);
+      if (s.pos() == s.get_data().size())
+        fail("</" + std::string(open.back()) + ">");
+      if (starts_with("<!--")) {
+        skip_past("-->");
+      } else if (starts_with("<![CDATA[")) {
+        skip_past("]]>");
+      } else if (starts_with("<?")) {
+        skip_past("?>");
+      } else if (starts_with("</")) {
+        skip_past(">");
+        d--;
+      } else if (starts_with("<!")) {
+        skip_doctype();
+      } else {
+        s.incr();
+        while (true) {
+          s.skip_until(tag_end);
+          if (s.pos() == s.get_data().size()) fail(">");
+          char c = s.peek();
+          s.incr();
+          if (c == '>') break;
+          skip_past(std::string_view(&c, 1));
+        }
+        if (s.get_data()[s.pos() - 2] != '/') d++;
+      }
+    }
+    close();
+  }
+
+  // Starts accumulating the text within the current element, each run
+  // followed by a space, leaving out the text of elements named skip and
+  // their descendants.  Captures nest.
+  void begin_capture(std::string_view skip) {
+    captures.push_back({std::string(), skip, 0});
+  }
+
+  std::string end_capture() {
+    std::string text = std::move(captures.back().text);
+    captures.pop_back();
+    return text;
+  }
+
+ private:
+  struct capture {
+    std::string text;
+    std::string_view skip;
+    size_t skip_depth;
+  };
+
+  [[noreturn]] void fail(std::string_view expected) {
+    LOG(FATAL) << filename << ":" << s.line() + 1 << ": expected " << expected
+               << " at offset " << s.pos();
+    abort();
+  }
+
+  bool starts_with(std::string_view prefix) const {
+    return s.get_data().substr(s.pos(), prefix.size()) == prefix;
+  }
+
+  void expect(char c) {
+    if (s.peek() != c) fail(std::string_view(&c, 1));
+    s.incr();
+  }
+
+  void skip_past(std::string_view terminator) {
+    size_t end = s.get_data().find(terminator, s.pos());
+    if (end == std::string_view::npos) fail(terminator);
+    s.pos(end + terminator.size());
+  }
+
+  // Skips a <!DOCTYPE ...> declaration, including any internal subset.
+  void skip_doctype() {
+    static constexpr byte_class special{{'[', '['}, {'>', '>'}};
+    s.skip_until(special);
+    if (s.peek() == '[') skip_past("]");
+    skip_past(">");
+  }
+
+  std::string_view read_name() {
+    static constexpr byte_class name_end{
+        {'\t', '\r'}, {' ', ' '}, {'/', '/'}, {'=', '>'}};
+    size_t begin = s.pos();
+    s.skip_until(name_end);
+    if (s.pos() == begin) fail("name");
+    return s.substr(begin, s.pos() - begin);
+  }
+
+  void read_start_tag() {
+    static constexpr byte_class double_quote{{'"', '"'}};
+    static constexpr byte_class single_quote{{'\'', '\''}};
+    s.incr();
+    name_ = read_name();
+    attributes_.clear();
+    attribute_scratch.clear();
+    decoded.clear();
+    while (true) {
+      s.skip_while(whitespace);
+      if (s.peek() == '/') {
+        s.incr();
+        expect('>');
+        pending_end = true;
+        break;
+      }
+      if (s.peek() == '>') {
+        s.incr();
+        break;
+      }
+      std::string_view attribute_name = read_name();
+      s.skip_while(whitespace);
+      expect('=');
+      s.skip_while(whitespace);
+      char quote = s.peek();
+      if (quote != '"' && quote != '\'') fail("quoted attribute value");
+      s.incr();
+      size_t begin = s.pos();
+      s.skip_until(quote == '"' ? double_quote : single_quote);
+      if (s.peek() != quote) fail(std::string_view(&quote, 1));
+      std::string_view raw = s.substr(begin, s.pos() - begin);
+      s.incr();
+      if (needs_decoding(raw)) {
+        // Decoded values are fixed up once the scratch buffer stops moving.
+        size_t offset = attribute_scratch.size();
+        decode(raw, attribute_scratch);
+        decoded.push_back({attributes_.size(), offset,
+                           attribute_scratch.size() - offset});
+      }
+      attributes_.push_back({attribute_name, raw});
+    }
+    for (const decoded_value& d : decoded)
+      attributes_[d.index].value =
+          std::string_view(attribute_scratch).substr(d.offset, d.size);
+    for (capture& c : captures)
+      if (c.skip_depth > 0 || name_ == c.skip) c.skip_depth++;
+    open.push_back(name_);
+  }
+
+  void read_end_tag() {
+    s.incr(2);
+    name_ = read_name();
+    s.skip_while(whitespace);
+    expect('>');
+    if (open.empty() || open.back() != name_)
+      fail(open.empty() ? "end of document"
+                        : "</" + std::string(open.back()) + ">");
+    close();
+  }
+
+  void close() {
+    name_ = open.back();
+    open.pop_back();
+    for (capture& c : captures)
+      if (c.skip_depth > 0) c.skip_depth--;
+  }
+
+  // Reads character data up to the next markup, returning whether it is a
+  // TEXT event.
+  bool read_text() {
+    static constexpr byte_class lt{{'<', '<'}};
+    size_t begin = s.pos();
+    s.skip_until(lt);
+    std::string_view raw = s.substr(begin, s.pos() - begin);
+    if (bytescan::skip_while(raw.data(), raw.data() + raw.size(),
+                             whitespace) == raw.data() + raw.size())
+      return false;
+    if (needs_decoding(raw)) {
+      text_scratch.clear();
+      decode(raw, text_scratch);
+      raw = text_scratch;
+    }
+    set_text(raw);
+    return true;
+  }
+
+  void set_text(std::string_view text) {
+    text_ = text;
+    for (capture& c : captures) {
+      if (c.skip_depth > 0) continue;
+      c.text += text;
+      c.text += ' ';
+    }
+  }
+
+  static bool needs_decoding(std::string_view raw) {
+    static constexpr byte_class special{{'&', '&'}, {'\r', '\r'}};
+    return bytescan::find_first_of(raw.data(), raw.data() + raw.size(),
+                                   special) != raw.data() + raw.size();
+  }
+
+  // Appends raw with character references decoded and line ends normalized.
+  // Unknown references are kept verbatim.
+  static void decode(std::string_view raw, std::string& out) {
+    for (size_t i = 0; i < raw.size(); i++) {
+      char c = raw[i];
+      if (c == '\r') {
+        out += '\n';
+        if (i + 1 < raw.size() && raw[i + 1] == '\n') i++;
+        continue;
+      }
+      if (c != '&') {
+        out += c;
+        continue;
+      }
+      size_t semi = raw.find(';', i);
+      if (semi == std::string_view::npos || !decode_reference(
+              raw.substr(i + 1, semi - i - 1), out)) {
+        out += c;
+        continue;
+      }
+      i = semi;
+    }
+  }
+
+  static bool decode_reference(std::string_view ref, std::string& out) {
+    if (ref == "lt") {
+      out += '<';
+    } else if (ref == "gt") {
+      out += '>';
+    } else if (ref == "amp") {
+      out += '&';
+    } else if (ref == "quot") {
+      out += '"';
+    } else if (ref == "apos") {
+      out += '\'';
+    } else if (ref.size() > 1 && ref[0] == '#') {
+      int base = 10;
+      ref.remove_prefix(1);
+      if (ref[0] == 'x') {
+        base = 16;
+        ref.remove_prefix(1);
+      }
+      uint32_t u = 0;
+      auto result =
+          std::from_chars(ref.data(), ref.data() + ref.size(), u, base);
+      if (ref.empty() || result.ptr != ref.data() + ref.size()) return false;
+      dvc::append_utf8(out, u);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  struct decoded_value {
+    size_t index;
+    size_t offset;
+    size_t size;
+  };
+
+  std::string filename;
+  dvc::scanner s;
+  size_t event_pos = 0;
+  bool pending_end = false;
+  std::string_view name_;
+  std::vector<attribute> attributes_;
+  std::string attribute_scratch;
+  std::vector<decoded_value> decoded;
+  std::string_view text_;
+  std::string text_scratch;
+  std::vector<std::string_view> open;
+  std::vector<capture> captures;
+};
+
+}  // namespace dvc
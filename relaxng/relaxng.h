@@ -1,13 +1,24 @@
 #pragma once
 
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include <tinyxml2.h>
 #include <glog/logging.h>
 
+#include "core/binary.h"
+#include "core/container.h"
+#include "core/intern.h"
 #include "core/json.h"
+#include "core/thread_pool.h"
+#include "core/xml.h"
 
 namespace relaxng {
 
@@ -26,10 +37,17 @@ enum class MemberDisposition {
 };
 
 struct GeneratedClass {
-  Element _element_;
+  // The source element, or nullptr for objects not parsed from a DOM.
+  Element _element_ = nullptr;
   bool _parsed_ = false;
 };
 
+// The base of classes reflected with capture_text, which keep their inner
+// text.  Other classes do not pay for the string.
+struct TextClass : GeneratedClass {
+  std::string _text_;
+};
+
 template<class Protocol>
 struct ProtocolReflection;
 
@@ -42,109 +60,900 @@ struct ClassReflection;
 template<class Class, size_t member_index>
 struct ClassMemberReflection;
 
-inline void set_member(std::optional<std::string>& t, std::string_view value) {
+// Attribute values and text content are interned.
+using String = dvc::interned_string;
+
+inline void set_member(std::optional<String>& t, std::string_view value) {
   t = value;
 }
 
-inline void set_member(std::string& t, std::string_view value) {
+inline void set_member(String& t, std::string_view value) {
   t = value;
 }
 
-inline void set_member(std::vector<std::string>& t, std::string_view value) {
-  t.push_back(std::string(value));
+inline void set_member(std::vector<String>& t, std::string_view value) {
+  t.emplace_back(value);
 }
 
-template<class Class, size_t member_index>
-void apply_attribute_i(Class& object, Attribute attribute, bool& found) {
-  using m = ClassMemberReflection<Class, member_index>;
-  if constexpr(m::member_kind == MemberKind::ATTRIBUTE) {
-    if (m::input_name == attribute->Name()) {
-      found = true;
-      set_member(object.*m::member_ptr, attribute->Value());
+// Typed attributes.  relaxngc gives an attribute declared xsd:integer an
+// int64_t member, one declared xsd:boolean or "true" | "false" a bool, and one
+// declared as any other choice of strings a generated enum class, so that the
+// value is parsed once, at load, rather than compared as a string at each use.
+
+// The spellings of the enumerators of a generated enum class: enumerator i
+// has value i.
+template<typename Enum>
+struct EnumReflection;
+
+template<typename T>
+constexpr bool is_scalar_v = std::is_same_v<T, int64_t> || std::is_same_v<T, bool> || std::is_enum_v<T>;
+
+inline bool parse_value(int64_t& t, std::string_view value) {
+  auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), t);
+  return ec == std::errc() && end == value.data() + value.size();
+}
+
+inline bool parse_value(bool& t, std::string_view value) {
+  if (value == "true")
+    t = true;
+  else if (value == "false")
+    t = false;
+  else
+    return false;
+  return true;
+}
+
+template<typename Enum, typename = std::enable_if_t<std::is_enum_v<Enum>>>
+bool parse_value(Enum& t, std::string_view value) {
+  const auto& names = EnumReflection<Enum>::names;
+  for (size_t i = 0; i < names.size(); i++)
+    if (names[i] == value) {
+      t = Enum(i);
+      return true;
+    }
+  return false;
+}
+
+// The spelling of an enumerator in the document.
+template<typename Enum, typename = std::enable_if_t<std::is_enum_v<Enum>>>
+std::string_view enum_name(Enum t) {
+  return EnumReflection<Enum>::names[size_t(t)];
+}
+
+// Sets an attribute member from the attribute's value, or returns false if
+// the value is not one of the member's type.
+inline bool set_attribute(String& t, std::string_view value) {
+  t = value;
+  return true;
+}
+
+inline bool set_attribute(std::optional<String>& t, std::string_view value) {
+  t = value;
+  return true;
+}
+
+template<typename T, typename = std::enable_if_t<is_scalar_v<T>>>
+bool set_attribute(T& t, std::string_view value) {
+  return parse_value(t, value);
+}
+
+template<typename T, typename = std::enable_if_t<is_scalar_v<T>>>
+bool set_attribute(std::optional<T>& t, std::string_view value) {
+  return parse_value(t.emplace(), value);
+}
+
+// Sets a member declared xsd:boolean, which may also be spelt "1" or "0";
+// one declared "true" | "false" takes only those.
+inline bool set_xsd_boolean(bool& t, std::string_view value) {
+  if (value == "1" || value == "0") {
+    t = value == "1";
+    return true;
+  }
+  return parse_value(t, value);
+}
+
+inline bool set_xsd_boolean(std::optional<bool>& t, std::string_view value) {
+  return set_xsd_boolean(t.emplace(), value);
+}
+
+// Whether member reflection m is of an xsd:boolean.
+template<class m, typename = void>
+struct is_xsd_boolean : std::false_type {};
+template<class m>
+struct is_xsd_boolean<m, std::enable_if_t<m::xsd_boolean>> : std::true_type {};
+
+// Sets the attribute member that reflection m describes.
+template<class m, typename T>
+bool set_attribute_member(T& t, std::string_view value) {
+  if constexpr (is_xsd_boolean<m>::value)
+    return set_xsd_boolean(t, value);
+  else
+    return set_attribute(t, value);
+}
+
+// Maps member input names to member indices with a perfect hash found at
+// compile time, so that dispatching an attribute or subelement costs one
+// hash, one string compare and one indirect call, whatever the number of
+// members.
+
+constexpr uint32_t name_hash(std::string_view name, uint32_t seed) {
+  uint32_t h = 2166136261u ^ seed;
+  for (char c : name) {
+    h ^= uint8_t(c);
+    h *= 16777619u;
+  }
+  // The low bits of an FNV-1a hash depend only on the low bits of the input.
+  return h ^ (h >> 16);
+}
+
+constexpr size_t name_table_size(size_t num_names) {
+  size_t size = 1;
+  while (size < 2 * num_names) size *= 2;
+  return size;
+}
+
+template<size_t num_members, size_t size>
+struct NameTable {
+  static constexpr uint8_t empty = UINT8_MAX;
+  static_assert(num_members < empty, "too many members");
+
+  uint32_t seed = 0;
+  std::array<uint8_t, size> slots = {};
+};
+
+template<size_t size, size_t num_members>
+constexpr NameTable<num_members, size> make_name_table(const std::array<std::string_view, num_members>& names, const std::array<MemberKind, num_members>& kinds, MemberKind kind) {
+  NameTable<num_members, size> table;
+  for (uint32_t seed = 0;; seed++) {
+    table.seed = seed;
+    for (size_t s = 0; s < size; s++)
+      table.slots[s] = table.empty;
+    bool collision = false;
+    for (size_t i = 0; i < num_members && !collision; i++) {
+      if (kinds[i] != kind) continue;
+      uint8_t& slot = table.slots[name_hash(names[i], seed) & (size - 1)];
+      collision = slot != table.empty;
+      slot = uint8_t(i);
     }
+    if (!collision) return table;
   }
 }
 
+template<class Class, MemberKind kind>
+struct MemberNames {
+  static constexpr size_t num_members = ClassReflection<Class>::num_members;
+  static constexpr size_t npos = size_t(-1);
+
+  template<size_t ... I>
+  static constexpr std::array<std::string_view, num_members> input_names(std::index_sequence<I...>) {
+    return {ClassMemberReflection<Class, I>::input_name...};
+  }
+
+  template<size_t ... I>
+  static constexpr std::array<MemberKind, num_members> member_kinds(std::index_sequence<I...>) {
+    return {ClassMemberReflection<Class, I>::member_kind...};
+  }
+
+  static constexpr std::array<std::string_view, num_members> names = input_names(std::make_index_sequence<num_members>());
+  static constexpr size_t size = name_table_size(num_members);
+  static constexpr NameTable<num_members, size> table = make_name_table<size>(names, member_kinds(std::make_index_sequence<num_members>()), kind);
+
+  // The index of the member of this kind named name, or npos.
+  static size_t find(std::string_view name) {
+    uint8_t i = table.slots[name_hash(name, table.seed) & (size - 1)];
+    return i != table.empty && names[i] == name ? i : npos;
+  }
+};
+
+template<class Class, size_t member_index>
+bool apply_attribute_i(Class& object, std::string_view value) {
+  using m = ClassMemberReflection<Class, member_index>;
+  if constexpr(m::member_kind == MemberKind::ATTRIBUTE)
+    return set_attribute_member<m>(object.*m::member_ptr, value);
+  else
+    return false;
+}
+
+// Sets the attribute named name, or returns false if Class has no such
+// attribute or value is not one of its type.
 template<class Class, size_t ... I>
-void apply_attribute(Class& object, Attribute attribute, std::index_sequence<I...>) {
-  bool found = false;
-  (apply_attribute_i<Class, I>(object, attribute, found),...);
-  CHECK(found) << attribute->Name() << " line " << attribute->GetLineNum();
+bool apply_attribute(Class& object, std::string_view name, std::string_view value, std::index_sequence<I...>) {
+  static constexpr std::array<bool (*)(Class&, std::string_view), sizeof...(I)> apply = {&apply_attribute_i<Class, I>...};
+  size_t i = MemberNames<Class, MemberKind::ATTRIBUTE>::find(name);
+  if (i == MemberNames<Class, MemberKind::ATTRIBUTE>::npos)
+    return false;
+  return apply[i](object, value);
 }
 
 template<typename T> struct remove_memptr;
 template<class C, typename T> struct remove_memptr<T C::* const> { using type = T; };
 template<typename T> using remove_memptr_t = typename remove_memptr<T>::type;
 
+template<class Row>
+class Table;
+
 template<typename T> struct remove_disposition { using type = T; static constexpr auto disposition = MemberDisposition::REQUIRED; };
 template<typename T> struct remove_disposition<std::optional<T>> { using type = T; static constexpr auto disposition = MemberDisposition::OPTIONAL; };
 template<typename T> struct remove_disposition<std::vector<T>> { using type = T; static constexpr auto disposition = MemberDisposition::MULTIPLE; };
+template<typename T> struct remove_disposition<Table<T>> { using type = T; static constexpr auto disposition = MemberDisposition::MULTIPLE; };
+
+template<typename T>
+constexpr bool is_text_member_v = std::is_same_v<T, String> || std::is_same_v<T, std::optional<String>> || std::is_same_v<T, std::vector<String>>;
+
+// A member that holds a value rather than a generated class: text, or a
+// typed attribute.
+template<typename T>
+constexpr bool is_value_member_v = is_text_member_v<T> || is_scalar_v<typename remove_disposition<T>::type>;
+
+// A repeated member stored by column (relaxngc --columnar), for classes whose
+// members are all required or optional values: text or typed attributes.
+// The required members of all rows are one parallel array, row i's at
+// [i * num_required, ...), so a pass over names scans contiguous memory.
+// Each row has a presence bitset over its optional members, and the values it
+// has are stored one after another from the row's offset into a shared array;
+// an absent member takes a bit rather than an empty std::optional.  Values
+// are stored in 8-byte slots: a String as its pool pointer, a typed value as
+// an integer.
+//
+// Tables are built and read like vectors, except that indexing and
+// iterating materialize a Row, without a source element.  get() and has()
+// read one member of one row without materializing it.
+template<class Row>
+class Table {
+ public:
+  using value_type = Row;
+
+  class const_iterator {
+   public:
+    const_iterator(const Table* table, size_t i) : table(table), i(i) {}
+    Row operator*() const { return (*table)[i]; }
+    const_iterator& operator++() {
+      i++;
+      return *this;
+    }
+    bool operator!=(const const_iterator& that) const { return i != that.i; }
+
+   private:
+    const Table* table;
+    size_t i;
+  };
+
+  size_t size() const { return present.size(); }
+  bool empty() const { return present.empty(); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+
+  void reserve(size_t n) {
+    required.reserve(n * num_required());
+    present.reserve(n);
+    offsets.reserve(n);
+  }
+
+  void push_back(const Row& row) {
+    static_assert(!ClassReflection<Row>::capture_text, "tables do not capture text");
+    static_assert(ClassReflection<Row>::num_members <= 64, "presence bits are a uint64_t");
+    present.push_back(0);
+    offsets.push_back(optional.size());
+    push_back(row, iseq());
+  }
+
+  Row operator[](size_t i) const {
+    Row row;
+    row._parsed_ = true;
+    materialize(row, i, iseq());
+    return row;
+  }
+
+  // The value of member_ptr in row i.
+  template<auto member_ptr>
+  auto get(size_t i) const {
+    return get_i<member_index_of<member_ptr>(iseq())>(i);
+  }
+
+  // Whether row i has the optional member_ptr.
+  template<auto member_ptr>
+  bool has(size_t i) const {
+    return has_i<member_index_of<member_ptr>(iseq())>(i);
+  }
+
+ private:
+  // Not an alias: Row's reflection follows the classes that contain tables.
+  static constexpr auto iseq() {
+    return std::make_index_sequence<ClassReflection<Row>::num_members>();
+  }
+
+  template<size_t member_index>
+  using member_t = remove_memptr_t<decltype(ClassMemberReflection<Row, member_index>::member_ptr)>;
+
+  template<size_t member_index>
+  static constexpr bool is_required() {
+    using T = member_t<member_index>;
+    using rd = remove_disposition<T>;
+    static_assert(is_value_member_v<T> && rd::disposition != MemberDisposition::MULTIPLE,
+                  "tables hold only required and optional values");
+    return rd::disposition == MemberDisposition::REQUIRED;
+  }
+
+  template<size_t member_index>
+  using value_t = typename remove_disposition<member_t<member_index>>::type;
+
+  static_assert(sizeof(uintptr_t) <= sizeof(uint64_t));
+
+  template<typename V>
+  static uint64_t to_slot(V v) {
+    if constexpr (std::is_same_v<V, String>)
+      return v.bits();
+    else
+      return uint64_t(v);
+  }
+
+  template<typename V>
+  static V from_slot(uint64_t slot) {
+    if constexpr (std::is_same_v<V, String>)
+      return String::from_bits(uintptr_t(slot));
+    else
+      return V(slot);
+  }
+
+  template<size_t ... I>
+  static constexpr size_t num_required(std::index_sequence<I...>) {
+    return (size_t(0) + ... + size_t(is_required<I>()));
+  }
+
+  static constexpr size_t num_required() { return num_required(iseq()); }
+
+  // The position of a required member among the required members.
+  template<size_t member_index, size_t ... I>
+  static constexpr size_t required_index(std::index_sequence<I...>) {
+    return (size_t(0) + ... + size_t(I < member_index && is_required<I>()));
+  }
+
+  template<size_t member_index>
+  bool has_i(size_t i) const {
+    static_assert(!is_required<member_index>());
+    return present[i] >> member_index & 1;
+  }
+
+  template<size_t member_index>
+  member_t<member_index> get_i(size_t i) const {
+    using V = value_t<member_index>;
+    if constexpr (is_required<member_index>()) {
+      return from_slot<V>(required[i * num_required() + required_index<member_index>(iseq())]);
+    } else {
+      if (!has_i<member_index>(i)) return std::nullopt;
+      uint64_t before = present[i] & ((uint64_t(1) << member_index) - 1);
+      return from_slot<V>(optional[offsets[i] + __builtin_popcountll(before)]);
+    }
+  }
+
+  template<size_t member_index>
+  void push_back_i(const member_t<member_index>& v) {
+    if constexpr (is_required<member_index>()) {
+      required.push_back(to_slot(v));
+    } else if (v) {
+      present.back() |= uint64_t(1) << member_index;
+      optional.push_back(to_slot(*v));
+    }
+  }
+
+  template<auto member_ptr, size_t member_index>
+  static constexpr bool is_member() {
+    constexpr auto p = ClassMemberReflection<Row, member_index>::member_ptr;
+    if constexpr (std::is_same_v<std::remove_const_t<decltype(p)>, decltype(member_ptr)>)
+      return p == member_ptr;
+    else
+      return false;
+  }
+
+  template<auto member_ptr, size_t ... I>
+  static constexpr size_t member_index_of(std::index_sequence<I...>) {
+    size_t index = sizeof...(I);
+    ((is_member<member_ptr, I>() ? index = I : 0), ...);
+    return index;
+  }
+
+  template<size_t ... I>
+  void push_back(const Row& row, std::index_sequence<I...>) {
+    (push_back_i<I>(row.*ClassMemberReflection<Row, I>::member_ptr), ...);
+  }
+
+  template<size_t ... I>
+  void materialize(Row& row, size_t i, std::index_sequence<I...>) const {
+    ((row.*ClassMemberReflection<Row, I>::member_ptr = get_i<I>(i)), ...);
+  }
+
+  std::vector<uint64_t> required;
+  // Bit m of present[i] is set if row i has optional member m, whose value
+  // is then among those from optional[offsets[i]], in member order.
+  std::vector<uint64_t> present;
+  std::vector<uint32_t> offsets;
+  std::vector<uint64_t> optional;
+};
+
+template<typename T> struct is_table : std::false_type {};
+template<typename T> struct is_table<Table<T>> : std::true_type {};
+template<typename T> constexpr bool is_table_v = is_table<T>::value;
+
+// Parses a subelement in place into a member of the given disposition, so
+// that no subtree is ever copied or moved.
+template<typename T, typename ParseIntoFn>
+void set_subelement(T& member, ParseIntoFn parse_into_fn, std::string_view name, size_t line) {
+  using rd = remove_disposition<T>;
+  if constexpr (rd::disposition == MemberDisposition::REQUIRED) {
+    CHECK(!member._parsed_) << "required member already present " << name << " line " << line;
+    parse_into_fn(member);
+  } else if constexpr (rd::disposition == MemberDisposition::OPTIONAL) {
+    CHECK(!member) << "optional member already present " << name << " line " << line;
+    parse_into_fn(member.emplace());
+  } else if constexpr (is_table_v<T>) {
+    typename rd::type row;
+    parse_into_fn(row);
+    member.push_back(row);
+  } else if constexpr (rd::disposition == MemberDisposition::MULTIPLE) {
+    parse_into_fn(member.emplace_back());
+  }
+}
+
+template<class Class, size_t member_index>
+void reserve_i(Class& object, size_t n) {
+  using m = ClassMemberReflection<Class, member_index>;
+  using T = remove_memptr_t<decltype(m::member_ptr)>;
+  if constexpr (m::member_kind == MemberKind::SUBELEMENT &&
+                remove_disposition<T>::disposition == MemberDisposition::MULTIPLE)
+    if (n > 0) (object.*m::member_ptr).reserve(n);
+}
+
+// Appends the text nodes within element, each followed by a space, leaving
+// out elements named skip.
+inline void append_inner_text(std::string& text, Element element, std::string_view skip) {
+  for (auto p = element->FirstChild(); p != nullptr; p = p->NextSibling()) {
+    if (auto node = p->ToText()) {
+      text += node->Value();
+      text += ' ';
+    } else if (auto subelement = p->ToElement()) {
+      if (subelement->Name() != skip)
+        append_inner_text(text, subelement, skip);
+    }
+  }
+}
+
+// Subtrees set aside by a parallel parse: the tasks that will parse them,
+// and how many levels the walk may still descend before setting subtrees
+// aside.
+struct Deferral {
+  std::vector<std::function<void()>> tasks;
+  size_t levels;
+};
 
 template<class Class>
-Class parse(Element element);
+void parse_into(Class& object, Element element, Deferral* deferral = nullptr);
+
+template<class Class>
+void parse_subtree(Class& object, Element element, Deferral* deferral) {
+  if (deferral == nullptr) {
+    parse_into(object, element);
+  } else if (deferral->levels == 0) {
+    // Marked now for the duplicate checks; the task parses into object.
+    object._parsed_ = true;
+    deferral->tasks.push_back([&object, element] { parse_into(object, element); });
+  } else {
+    deferral->levels--;
+    parse_into(object, element, deferral);
+    deferral->levels++;
+  }
+}
 
 template<class Class, size_t member_index>
-void apply_subelement_i(Class& object, Element subelement) {
+void apply_subelement_i(Class& object, Element subelement, Deferral* deferral) {
   using m = ClassMemberReflection<Class, member_index>;
   if constexpr(m::member_kind == MemberKind::SUBELEMENT) {
-    if (m::input_name == subelement->Name()) {
-      using T = remove_memptr_t<decltype(m::member_ptr)>;
-      if constexpr(std::is_same_v<T, std::string> || std::is_same_v<T, std::optional<std::string>> || std::is_same_v<T, std::vector<std::string>>)
-          set_member(object.*m::member_ptr, subelement->GetText());
-      else {
-        using rd = remove_disposition<T>;
-        using SubelementClass = typename rd::type;
-        if constexpr (rd::disposition == MemberDisposition::REQUIRED) {
-          CHECK(!(object.*m::member_ptr)._parsed_) << "required member already present " << subelement->Name() << " line " << subelement->GetLineNum();
-          object.*m::member_ptr = parse<SubelementClass>(subelement);
-        } else if constexpr (rd::disposition == MemberDisposition::OPTIONAL) {
-          CHECK(!(object.*m::member_ptr)) << "optional member already present " << subelement->Name() << " line " << subelement->GetLineNum();
-          object.*m::member_ptr = parse<SubelementClass>(subelement);
-        } else if constexpr (rd::disposition == MemberDisposition::MULTIPLE) {
-          (object.*m::member_ptr).push_back(parse<SubelementClass>(subelement));
-        }
-      }
-    }
+    using T = remove_memptr_t<decltype(m::member_ptr)>;
+    if constexpr(is_text_member_v<T>)
+        set_member(object.*m::member_ptr, subelement->GetText());
+    else
+      // Table rows are parsed into a temporary, so never deferred.
+      set_subelement(object.*m::member_ptr, [&](auto& member) { parse_subtree(member, subelement, is_table_v<T> ? nullptr : deferral); },
+                     subelement->Name(), subelement->GetLineNum());
   }
 }
 
 template<class Class, size_t ... I>
-void apply_subelement(Class& object, Element subelement, std::index_sequence<I...>) {
-  (void)subelement;
-  (apply_subelement_i<Class, I>(object, subelement),...);
+void apply_subelement(Class& object, Element subelement, Deferral* deferral, std::index_sequence<I...>) {
+  static constexpr std::array<void (*)(Class&, Element, Deferral*), sizeof...(I)> apply = {&apply_subelement_i<Class, I>...};
+  size_t i = MemberNames<Class, MemberKind::SUBELEMENT>::find(subelement->Name());
+  if (i != MemberNames<Class, MemberKind::SUBELEMENT>::npos)
+    apply[i](object, subelement, deferral);
+}
+
+// Sizes each repeated member from a count of its subelements, so that each
+// is built in a single allocation.  A parallel parse also relies on this:
+// deferred subtrees are parsed into vector elements that must not move.
+template<class Class, size_t ... I>
+void reserve_subelements(Class& object, Element element, std::index_sequence<I...>) {
+  using names = MemberNames<Class, MemberKind::SUBELEMENT>;
+  std::array<size_t, sizeof...(I)> counts = {};
+  for (Element subelement = element->FirstChildElement(); subelement != nullptr; subelement = subelement->NextSiblingElement()) {
+    size_t i = names::find(subelement->Name());
+    if (i != names::npos) counts[i]++;
+  }
+  (reserve_i<Class, I>(object, counts[I]),...);
 }
 
 template<class Class>
-Class parse(Element element) {
-  Class object;
+void parse_into(Class& object, Element element, Deferral* deferral) {
+  // Vectors of generated classes relocate their elements by moving them.
+  static_assert(std::is_nothrow_move_constructible_v<Class>);
+
   object._element_ = element;
   object._parsed_ = true;
 
   using iseq = std::make_index_sequence<ClassReflection<Class>::num_members>;
 
   for (Attribute attribute = element->FirstAttribute(); attribute != nullptr; attribute = attribute->Next())
-    apply_attribute(object, attribute, iseq());
+    CHECK(apply_attribute(object, attribute->Name(), attribute->Value(), iseq())) << attribute->Name() << "=\"" << attribute->Value() << "\" line " << attribute->GetLineNum();
 
+  reserve_subelements(object, element, iseq());
   for (Element subelement = element->FirstChildElement(); subelement != nullptr; subelement = subelement->NextSiblingElement()) {
-    apply_subelement(object, subelement, iseq());
+    apply_subelement(object, subelement, deferral, iseq());
   }
+
+  if constexpr (ClassReflection<Class>::capture_text)
+    append_inner_text(object._text_, element, ClassReflection<Class>::text_skip);
+}
+
+template<class Class>
+Class parse(Element element) {
+  Class object;
+  parse_into(object, element);
   return object;
 }
 
+// Parses as parse() does, but walks only the top `levels` levels of the
+// tree on the calling thread.  The subtrees below are parsed on pool, each
+// in place in its slot in document order.  The result is identical to
+// parse()'s.
+template<class Class>
+Class parse_parallel(Element element, dvc::thread_pool& pool, size_t levels = 2) {
+  CHECK_GT(levels, 0u);
+  Class object;
+  Deferral deferral{{}, levels - 1};
+  parse_into(object, element, &deferral);
+  pool.parallel_for(deferral.tasks.size(), [&](size_t i) { deferral.tasks[i](); });
+  return object;
+}
+
+// The streaming backend: populates the generated classes directly from the
+// events of an xml_reader, without a document tree.  Objects parsed this way
+// have no source element.
+
+template<class Class>
+void parse_into(Class& object, dvc::xml_reader& r);
+
+// Reads the element just started as a text member: as tinyxml2's GetText,
+// its first child, if it is text.
+template<typename T>
+void read_text_subelement(T& member, dvc::xml_reader& r) {
+  size_t depth = r.depth();
+  set_member(member, r.next() == dvc::xml_reader::TEXT ? r.text() : std::string_view());
+  r.skip_to_end(depth);
+}
+
+template<class Class, size_t member_index>
+void read_subelement_i(Class& object, dvc::xml_reader& r) {
+  using m = ClassMemberReflection<Class, member_index>;
+  if constexpr(m::member_kind == MemberKind::SUBELEMENT) {
+    using T = remove_memptr_t<decltype(m::member_ptr)>;
+    if constexpr(is_text_member_v<T>) {
+      read_text_subelement(object.*m::member_ptr, r);
+    } else {
+      set_subelement(object.*m::member_ptr, [&](auto& member) { parse_into(member, r); },
+                     r.name(), r.line());
+    }
+  }
+}
+
+template<class Class, size_t ... I>
+void read_subelement(Class& object, dvc::xml_reader& r, std::index_sequence<I...>) {
+  static constexpr std::array<void (*)(Class&, dvc::xml_reader&), sizeof...(I)> read = {&read_subelement_i<Class, I>...};
+  size_t i = MemberNames<Class, MemberKind::SUBELEMENT>::find(r.name());
+  if (i != MemberNames<Class, MemberKind::SUBELEMENT>::npos)
+    read[i](object, r);
+  else
+    r.skip_element();
+}
+
+// Parses the element whose START_ELEMENT event r is positioned at into
+// object, consuming it through its END_ELEMENT.  The children are not known
+// in advance, so repeated members grow as they are read; their elements are
+// relocated by moving.
+template<class Class>
+void parse_into(Class& object, dvc::xml_reader& r) {
+  static_assert(std::is_nothrow_move_constructible_v<Class>);
+
+  object._element_ = nullptr;
+  object._parsed_ = true;
+
+  using reflection = ClassReflection<Class>;
+  using iseq = std::make_index_sequence<reflection::num_members>;
+
+  for (const dvc::xml_reader::attribute& attribute : r.attributes())
+    CHECK(apply_attribute(object, attribute.name, attribute.value, iseq())) << attribute.name << "=\"" << attribute.value << "\" line " << r.line();
+
+  if constexpr (reflection::capture_text)
+    r.begin_capture(reflection::text_skip);
+  for (auto event = r.next(); event != dvc::xml_reader::END_ELEMENT; event = r.next())
+    if (event == dvc::xml_reader::START_ELEMENT)
+      read_subelement(object, r, iseq());
+  if constexpr (reflection::capture_text)
+    object._text_ = r.end_capture();
+}
+
+template<class Class>
+Class parse(dvc::xml_reader& r) {
+  Class object;
+  parse_into(object, r);
+  return object;
+}
+
+// Parses a whole document whose root element is a Class.
+template<class Class>
+Class parse_document(dvc::xml_reader& r) {
+  dvc::xml_reader::event event;
+  while ((event = r.next()) != dvc::xml_reader::START_ELEMENT)
+    CHECK(event != dvc::xml_reader::END_DOCUMENT) << "no root element";
+  Class object;
+  parse_into(object, r);
+  while ((event = r.next()) != dvc::xml_reader::END_DOCUMENT)
+    CHECK(event != dvc::xml_reader::START_ELEMENT) << "more than one root element line " << r.line();
+  return object;
+}
+
+// Lazy views.  A view is a handle on one element of a document held in
+// memory, typically a mapped file.  Its accessors read the element's start
+// tag, or scan its children, on first use and cache the result; a child
+// element becomes a view in turn and is not read until accessed.  What a view
+// reads is checked as parse() checks it, but only once read.  The ViewSource
+// must outlive the views of it, and views are not thread-safe.
+//
+// relaxngc --emit_views generates a view class for each class, deriving from
+// View and naming an accessor after each member.
+
+struct ViewSource {
+  std::string filename;
+  std::string_view xml;
+};
+
+// The type of a member of a view: a value member as it is, a subelement as
+// the view of its class.
+template<typename T, bool = is_value_member_v<T>>
+struct view_member { using type = T; };
+template<typename T>
+struct view_member<T, false> { using type = typename ClassReflection<T>::view; };
+template<typename T>
+struct view_member<std::optional<T>, false> { using type = std::optional<typename ClassReflection<T>::view>; };
+template<typename T>
+struct view_member<std::vector<T>, false> { using type = std::vector<typename ClassReflection<T>::view>; };
+template<typename T>
+struct view_member<Table<T>, false> { using type = std::vector<typename ClassReflection<T>::view>; };
+
+template<class Class>
+class View {
+ public:
+  View() = default;
+  View(const ViewSource* source, size_t offset) : source(source), offset(offset) {}
+
+  // False for the view of a required member whose element is missing.
+  explicit operator bool() const { return source != nullptr; }
+
+  // The inner text, as parse() captures it.
+  const std::string& text() const {
+    static_assert(ClassReflection<Class>::capture_text);
+    return load(TEXT).text;
+  }
+
+  // Parses the whole element.
+  Class parse() const {
+    CHECK(source != nullptr) << "view of a missing element";
+    dvc::xml_reader r(source->filename, source->xml, offset);
+    r.next();
+    return relaxng::parse<Class>(r);
+  }
+
+ protected:
+  template<size_t member_index>
+  const auto& get() const {
+    constexpr bool attribute = ClassMemberReflection<Class, member_index>::member_kind == MemberKind::ATTRIBUTE;
+    return std::get<member_index>(load(attribute ? ATTRIBUTES : CHILDREN).members);
+  }
+
+ private:
+  using iseq = std::make_index_sequence<ClassReflection<Class>::num_members>;
+
+  template<size_t ... I>
+  static auto members_type(std::index_sequence<I...>)
+      -> std::tuple<typename view_member<remove_memptr_t<decltype(ClassMemberReflection<Class, I>::member_ptr)>>::type...>;
+  using Members = decltype(members_type(iseq()));
+
+  struct Cache {
+    Members members;
+    std::string text;
+  };
+
+  enum Part : uint8_t { ATTRIBUTES = 1, CHILDREN = 2, TEXT = 4 };
+
+  template<size_t member_index>
+  static bool apply_attribute_i(Members& members, std::string_view value) {
+    if constexpr (ClassMemberReflection<Class, member_index>::member_kind == MemberKind::ATTRIBUTE)
+      return set_attribute_member<ClassMemberReflection<Class, member_index>>(std::get<member_index>(members), value);
+    else
+      return false;
+  }
+
+  template<size_t ... I>
+  static bool apply_attribute(Members& members, std::string_view name, std::string_view value, std::index_sequence<I...>) {
+    static constexpr std::array<bool (*)(Members&, std::string_view), sizeof...(I)> apply = {&apply_attribute_i<I>...};
+    size_t i = MemberNames<Class, MemberKind::ATTRIBUTE>::find(name);
+    if (i == MemberNames<Class, MemberKind::ATTRIBUTE>::npos)
+      return false;
+    return apply[i](members, value);
+  }
+
+  template<size_t member_index>
+  static void read_subelement_i(Members& members, const ViewSource* source, dvc::xml_reader& r) {
+    if constexpr (ClassMemberReflection<Class, member_index>::member_kind == MemberKind::SUBELEMENT) {
+      auto& member = std::get<member_index>(members);
+      using T = std::decay_t<decltype(member)>;
+      if constexpr (is_text_member_v<T>) {
+        read_text_subelement(member, r);
+      } else {
+        using rd = remove_disposition<T>;
+        if constexpr (rd::disposition == MemberDisposition::MULTIPLE) {
+          member.emplace_back(source, r.offset());
+        } else {
+          CHECK(!member) << "member already present " << r.name() << " line " << r.line();
+          if constexpr (rd::disposition == MemberDisposition::OPTIONAL)
+            member.emplace(source, r.offset());
+          else
+            member = T(source, r.offset());
+        }
+        r.skip_element();
+      }
+    }
+  }
+
+  template<size_t ... I>
+  static void read_subelement(Members& members, const ViewSource* source, dvc::xml_reader& r, std::index_sequence<I...>) {
+    static constexpr std::array<void (*)(Members&, const ViewSource*, dvc::xml_reader&), sizeof...(I)> read = {&read_subelement_i<I>...};
+    size_t i = MemberNames<Class, MemberKind::SUBELEMENT>::find(r.name());
+    if (i != MemberNames<Class, MemberKind::SUBELEMENT>::npos)
+      read[i](members, source, r);
+    else
+      r.skip_element();
+  }
+
+  const Cache& load(Part part) const {
+    if (cache && (loaded & part)) return *cache;
+    CHECK(source != nullptr) << "view of a missing element";
+    if (!cache) cache = std::make_unique<Cache>();
+    dvc::xml_reader r(source->filename, source->xml, offset);
+    r.next();
+    if (part == ATTRIBUTES) {
+      for (const dvc::xml_reader::attribute& attribute : r.attributes())
+        CHECK(apply_attribute(cache->members, attribute.name, attribute.value, iseq())) << attribute.name << "=\"" << attribute.value << "\" line " << r.line();
+    } else if (part == CHILDREN) {
+      for (auto event = r.next(); event != dvc::xml_reader::END_ELEMENT; event = r.next())
+        if (event == dvc::xml_reader::START_ELEMENT)
+          read_subelement(cache->members, source, r, iseq());
+    } else if constexpr (ClassReflection<Class>::capture_text) {
+      r.begin_capture(ClassReflection<Class>::text_skip);
+      r.skip_element();
+      cache->text = r.end_capture();
+    }
+    loaded |= part;
+    return *cache;
+  }
+
+  const ViewSource* source = nullptr;
+  size_t offset = 0;
+  mutable std::unique_ptr<Cache> cache;
+  mutable uint8_t loaded = 0;
+};
+
+// A view of the root element of source's document.
+template<class ViewClass>
+ViewClass view_document(const ViewSource& source) {
+  dvc::xml_reader r(source.filename, source.xml);
+  dvc::xml_reader::event event;
+  while ((event = r.next()) != dvc::xml_reader::START_ELEMENT)
+    CHECK(event != dvc::xml_reader::END_DOCUMENT) << "no root element";
+  return ViewClass(&source, r.offset());
+}
+
+template<class Class>
+bool equal(const Class& a, const Class& b);
+
+template<class Class, size_t member_index>
+bool equal_i(const Class& a, const Class& b) {
+  using m = ClassMemberReflection<Class, member_index>;
+  using T = remove_memptr_t<decltype(m::member_ptr)>;
+  const auto& x = a.*m::member_ptr;
+  const auto& y = b.*m::member_ptr;
+  if constexpr (is_value_member_v<T>) {
+    return x == y;
+  } else {
+    using rd = remove_disposition<T>;
+    if constexpr (rd::disposition == MemberDisposition::REQUIRED) {
+      return equal(x, y);
+    } else if constexpr (rd::disposition == MemberDisposition::OPTIONAL) {
+      return x.has_value() == y.has_value() && (!x || equal(*x, *y));
+    } else if constexpr (rd::disposition == MemberDisposition::MULTIPLE) {
+      if (x.size() != y.size()) return false;
+      for (size_t i = 0; i < x.size(); i++)
+        if (!equal(x[i], y[i])) return false;
+      return true;
+    }
+  }
+}
+
+template<class Class, size_t ... I>
+bool equal(const Class& a, const Class& b, std::index_sequence<I...>) {
+  (void)a;
+  (void)b;
+  return (equal_i<Class, I>(a, b) && ...);
+}
+
+// Compares two trees member by member, including captured text but not
+// source elements.
+template<class Class>
+bool equal(const Class& a, const Class& b) {
+  using iseq = std::make_index_sequence<ClassReflection<Class>::num_members>;
+  if constexpr (ClassReflection<Class>::capture_text)
+    if (a._text_ != b._text_) return false;
+  return a._parsed_ == b._parsed_ && equal(a, b, iseq());
+}
+
+// Integers as JSON numbers, booleans as JSON booleans, and enumerators as
+// their spellings.
+template<typename T>
+void write_json_value(dvc::json_writer& w, T value) {
+  if constexpr (std::is_same_v<T, bool>) {
+    w.write_bool(value);
+  } else if constexpr (std::is_enum_v<T>) {
+    w.write_string(enum_name(value));
+  } else {
+    char buf[24];
+    w.write_raw(std::string_view(buf, std::to_chars(buf, buf + sizeof buf, value).ptr - buf));
+  }
+}
+
+template<typename T>
+T read_json_value(dvc::json_reader& r) {
+  if constexpr (std::is_same_v<T, bool>) {
+    return r.read_bool();
+  } else if constexpr (std::is_enum_v<T>) {
+    T value{};
+    std::string_view name = r.read_string();
+    CHECK(parse_value(value, name)) << "unknown enumerator " << name;
+    return value;
+  } else {
+    return r.read_integer();
+  }
+}
+
 template<class Class, size_t member_index>
 void write_json_i(dvc::json_writer& w, const Class& object) {
   using m = ClassMemberReflection<Class, member_index>;
   using T = remove_memptr_t<decltype(m::member_ptr)>;
   const auto& value = object.*m::member_ptr;
-  if constexpr(std::is_same_v<T, std::string>) {
+  if constexpr(std::is_same_v<T, String>) {
     w.write_key(m::output_name);
     w.write_string(value);
-  } else if constexpr(std::is_same_v<T, std::optional<std::string>>) {
+  } else if constexpr(std::is_same_v<T, std::optional<String>>) {
     if (value) {
       w.write_key(m::output_name);
       w.write_string(*value);
     }
-  } else if constexpr (std::is_same_v<T, std::vector<std::string>>) {
+  } else if constexpr (std::is_same_v<T, std::vector<String>>) {
     if (!value.empty()) {
       w.write_key(m::output_name);
       w.start_array();
@@ -152,6 +961,14 @@ void write_json_i(dvc::json_writer& w, const Class& object) {
         w.write_string(v);
       w.end_array();
     }
+  } else if constexpr (is_scalar_v<T>) {
+    w.write_key(m::output_name);
+    write_json_value(w, value);
+  } else if constexpr (is_value_member_v<T>) {
+    if (value) {
+      w.write_key(m::output_name);
+      write_json_value(w, *value);
+    }
   } else {
     using rd = remove_disposition<T>;
     if constexpr (rd::disposition == MemberDisposition::REQUIRED) {
@@ -187,4 +1004,411 @@ void write_json(dvc::json_writer& w, const Class& object) {
   w.end_object();
 }
 
+template<class Class>
+Class read_json(dvc::json_reader& r);
+
+template<class Class, size_t member_index>
+bool read_json_i(dvc::json_reader& r, Class& object, std::string_view key) {
+  using m = ClassMemberReflection<Class, member_index>;
+  if (m::output_name != key)
+    return false;
+  using T = remove_memptr_t<decltype(m::member_ptr)>;
+  auto& value = object.*m::member_ptr;
+  if constexpr(std::is_same_v<T, String> || std::is_same_v<T, std::optional<String>>) {
+    set_member(value, r.read_string());
+  } else if constexpr (std::is_same_v<T, std::vector<String>>) {
+    r.start_array();
+    while (r.next_element())
+      set_member(value, r.read_string());
+  } else if constexpr (is_value_member_v<T>) {
+    value = read_json_value<typename remove_disposition<T>::type>(r);
+  } else {
+    using rd = remove_disposition<T>;
+    using SubelementClass = typename rd::type;
+    if constexpr (rd::disposition == MemberDisposition::MULTIPLE) {
+      r.start_array();
+      while (r.next_element())
+        value.push_back(read_json<SubelementClass>(r));
+    } else {
+      value = read_json<SubelementClass>(r);
+    }
+  }
+  return true;
+}
+
+template<class Class, size_t ... I>
+bool read_json(dvc::json_reader& r, Class& object, std::string_view key, std::index_sequence<I...>) {
+  (void)r;
+  (void)object;
+  return (read_json_i<Class, I>(r, object, key) || ...);
+}
+
+// Reads an object written by write_json.  Objects read this way have no
+// source element.
+template<class Class>
+Class read_json(dvc::json_reader& r) {
+  Class object;
+  object._element_ = nullptr;
+  object._parsed_ = true;
+
+  using iseq = std::make_index_sequence<ClassReflection<Class>::num_members>;
+
+  r.start_object();
+  std::string_view key;
+  while (r.next_key(key))
+    CHECK(read_json(r, object, key, iseq())) << "unknown member " << key;
+  return object;
+}
+
+// Binary snapshots.  A snapshot is a header, a string table and the tree:
+//
+//   header   "rngsnap" and a version byte, 2, u64 schema hash, u64 source
+//            size, u64 source hash, u64 hash of the strings and tree, u32
+//            string count, u32 string data size, u32 tree size
+//   strings  the u32 end offset of each string, then the string data padded
+//            to a multiple of 4 bytes
+//   tree     the root object
+//
+// Fields are little-endian and sections 4-byte aligned, so a mapped snapshot
+// is read in place.  The string table holds the interned strings.  An object
+// is its size in bytes, its flags (bit 0: parsed), its text if its class
+// captures text (the length, then the bytes padded to a multiple of 4), then
+// its members in reflection order: strings as string table indices (optional
+// ones as index + 1, or 0 when absent), integers as u64 and booleans and
+// enumerators as u32 (optional ones preceded by 0 or 1, and only the 0 when
+// absent), optional objects as 0 or 1 followed by the object, and repeated
+// members as a count followed by the elements.  The size prefix lets readers
+// skip whole subtrees.
+
+inline constexpr std::string_view snapshot_magic{"rngsnap\2", 8};
+inline constexpr size_t snapshot_header_size = 52;
+// The size of the smallest object: its size and flags.
+inline constexpr size_t snapshot_min_object_size = 8;
+
+// Snapshot hashes are 64-bit FNV-1a, from this offset basis.
+inline constexpr uint64_t snapshot_hash_basis = dvc::fnv1a_basis;
+
+constexpr uint64_t snapshot_hash(uint64_t h, std::string_view s) {
+  return dvc::fnv1a(h, s);
+}
+
+constexpr uint64_t snapshot_hash(uint64_t h, uint64_t v) {
+  for (int i = 0; i < 8; i++) {
+    h ^= uint8_t(v >> (8 * i));
+    h *= 1099511628211u;
+  }
+  return h;
+}
+
+// A hash of the shape of Class and everything it contains: what a snapshot
+// written by one build must agree on to be read by another.
+template<class Class>
+struct SchemaHash;
+
+template<class Class, size_t member_index>
+constexpr uint64_t member_schema_hash(uint64_t h) {
+  using m = ClassMemberReflection<Class, member_index>;
+  using T = remove_memptr_t<decltype(m::member_ptr)>;
+  using rd = remove_disposition<T>;
+  h = snapshot_hash(h, m::output_name);
+  h = snapshot_hash(h, m::input_name);
+  h = snapshot_hash(h, uint64_t(m::member_kind));
+  h = snapshot_hash(h, uint64_t(rd::disposition));
+  using V = typename rd::type;
+  if constexpr (is_text_member_v<T>) {
+    return snapshot_hash(h, uint64_t(0));
+  } else if constexpr (std::is_same_v<V, int64_t>) {
+    return snapshot_hash(h, uint64_t(1));
+  } else if constexpr (std::is_same_v<V, bool>) {
+    return snapshot_hash(h, uint64_t(2));
+  } else if constexpr (std::is_enum_v<V>) {
+    h = snapshot_hash(h, uint64_t(3));
+    for (std::string_view name : EnumReflection<V>::names)
+      h = snapshot_hash(h, name);
+    return h;
+  } else {
+    return snapshot_hash(h, SchemaHash<V>::value);
+  }
+}
+
+template<class Class, size_t ... I>
+constexpr uint64_t schema_hash(std::index_sequence<I...>) {
+  uint64_t h = snapshot_hash(snapshot_hash_basis, uint64_t(sizeof...(I)));
+  h = snapshot_hash(h, uint64_t(ClassReflection<Class>::capture_text));
+  ((h = member_schema_hash<Class, I>(h)), ...);
+  return h;
+}
+
+template<class Class>
+struct SchemaHash {
+  static constexpr uint64_t value = schema_hash<Class>(std::make_index_sequence<ClassReflection<Class>::num_members>());
+};
+
+class SnapshotWriter {
+ public:
+  // The index of s in the string table.  s must outlive the writer.
+  uint32_t string(std::string_view s) {
+    auto [it, inserted] = index.try_emplace(s, uint32_t(strings.size()));
+    if (inserted) strings.push_back(s);
+    return it->second;
+  }
+
+  std::string finish(uint64_t schema_hash, std::string_view source) {
+    dvc::binary_writer out;
+    size_t data_size = 0;
+    for (std::string_view s : strings) data_size += s.size();
+    out.bytes(snapshot_magic);
+    out.u64(schema_hash);
+    out.u64(source.size());
+    out.u64(snapshot_hash(snapshot_hash_basis, source));
+    size_t body_hash = out.size();
+    out.u64(0);
+    out.u32(strings.size());
+    out.u32(data_size);
+    out.u32(tree.size());
+    DCHECK_EQ(out.size(), snapshot_header_size);
+    uint32_t end = 0;
+    for (std::string_view s : strings)
+      out.u32(end += s.size());
+    for (std::string_view s : strings)
+      out.bytes(s);
+    out.pad();
+    out.bytes(tree.str());
+    uint64_t h = snapshot_hash(snapshot_hash_basis,
+                               std::string_view(out.str()).substr(snapshot_header_size));
+    out.patch_u64(body_hash, h);
+    return std::move(out.str());
+  }
+
+  dvc::binary_writer tree;
+
+ private:
+  dvc::dense_hash_map<std::string_view, uint32_t> index;
+  std::vector<std::string_view> strings;
+};
+
+class SnapshotReader {
+ public:
+  SnapshotReader(const std::vector<std::string_view>& strings, std::string_view tree)
+      : tree(tree), interned(strings.begin(), strings.end()) {}
+
+  String string(uint32_t i) {
+    if (i >= interned.size()) {
+      tree.fail();
+      return {};
+    }
+    return interned[i];
+  }
+
+  dvc::binary_reader tree;
+
+ private:
+  std::vector<String> interned;
+};
+
+template<class Class>
+void write_binary_object(SnapshotWriter& w, const Class& object);
+
+template<typename T>
+void write_binary_value(SnapshotWriter& w, T value) {
+  if constexpr (std::is_same_v<T, int64_t>)
+    w.tree.u64(value);
+  else
+    w.tree.u32(uint32_t(value));
+}
+
+template<typename T>
+T read_binary_value(SnapshotReader& r) {
+  if constexpr (std::is_same_v<T, int64_t>) {
+    return r.tree.u64();
+  } else if constexpr (std::is_enum_v<T>) {
+    uint32_t v = r.tree.u32();
+    if (v >= EnumReflection<T>::names.size()) {
+      r.tree.fail();
+      return T();
+    }
+    return T(v);
+  } else {
+    return T(r.tree.u32());
+  }
+}
+
+template<class Class, size_t member_index>
+void write_binary_i(SnapshotWriter& w, const Class& object) {
+  using m = ClassMemberReflection<Class, member_index>;
+  using T = remove_memptr_t<decltype(m::member_ptr)>;
+  const auto& value = object.*m::member_ptr;
+  if constexpr(std::is_same_v<T, String>) {
+    w.tree.u32(w.string(value));
+  } else if constexpr(std::is_same_v<T, std::optional<String>>) {
+    w.tree.u32(value ? w.string(*value) + 1 : 0);
+  } else if constexpr (std::is_same_v<T, std::vector<String>>) {
+    w.tree.u32(value.size());
+    for (const auto& v : value)
+      w.tree.u32(w.string(v));
+  } else if constexpr (is_scalar_v<T>) {
+    write_binary_value(w, value);
+  } else if constexpr (is_value_member_v<T>) {
+    w.tree.u32(value.has_value());
+    if (value)
+      write_binary_value(w, *value);
+  } else {
+    using rd = remove_disposition<T>;
+    if constexpr (rd::disposition == MemberDisposition::REQUIRED) {
+      write_binary_object(w, value);
+    } else if constexpr (rd::disposition == MemberDisposition::OPTIONAL) {
+      w.tree.u32(value.has_value());
+      if (value)
+        write_binary_object(w, *value);
+    } else if constexpr (rd::disposition == MemberDisposition::MULTIPLE) {
+      w.tree.u32(value.size());
+      for (const auto& v : value)
+        write_binary_object(w, v);
+    }
+  }
+}
+
+template<class Class, size_t ... I>
+void write_binary_object(SnapshotWriter& w, const Class& object, std::index_sequence<I...>) {
+  (void)w;
+  (void)object;
+  (write_binary_i<Class, I>(w, object),...);
+}
+
+template<class Class>
+void write_binary_object(SnapshotWriter& w, const Class& object) {
+  size_t begin = w.tree.size();
+  w.tree.u32(0);
+  w.tree.u32(object._parsed_ ? 1 : 0);
+  if constexpr (ClassReflection<Class>::capture_text) {
+    w.tree.u32(object._text_.size());
+    w.tree.bytes(object._text_);
+    w.tree.pad();
+  }
+  write_binary_object(w, object, std::make_index_sequence<ClassReflection<Class>::num_members>());
+  w.tree.patch_u32(begin, w.tree.size() - begin);
+}
+
+// Serializes object as a snapshot.  source is the input it was parsed from,
+// whose size and FNV-1a hash are recorded so that stale snapshots are
+// ignored.
+template<class Class>
+std::string write_binary(const Class& object, std::string_view source = {}) {
+  SnapshotWriter w;
+  write_binary_object(w, object);
+  return w.finish(SchemaHash<Class>::value, source);
+}
+
+template<class Class>
+void read_binary_object(SnapshotReader& r, Class& object);
+
+template<class Class, size_t member_index>
+void read_binary_i(SnapshotReader& r, Class& object) {
+  using m = ClassMemberReflection<Class, member_index>;
+  using T = remove_memptr_t<decltype(m::member_ptr)>;
+  auto& value = object.*m::member_ptr;
+  if constexpr(std::is_same_v<T, String>) {
+    value = r.string(r.tree.u32());
+  } else if constexpr(std::is_same_v<T, std::optional<String>>) {
+    if (uint32_t i = r.tree.u32())
+      value = r.string(i - 1);
+  } else if constexpr (std::is_same_v<T, std::vector<String>>) {
+    value.resize(r.tree.count(4));
+    for (auto& v : value)
+      v = r.string(r.tree.u32());
+  } else if constexpr (is_scalar_v<T>) {
+    value = read_binary_value<T>(r);
+  } else if constexpr (is_value_member_v<T>) {
+    if (r.tree.u32())
+      value = read_binary_value<typename remove_disposition<T>::type>(r);
+  } else {
+    using rd = remove_disposition<T>;
+    if constexpr (rd::disposition == MemberDisposition::REQUIRED) {
+      read_binary_object(r, value);
+    } else if constexpr (rd::disposition == MemberDisposition::OPTIONAL) {
+      if (r.tree.u32())
+        read_binary_object(r, value.emplace());
+    } else if constexpr (is_table_v<T>) {
+      uint32_t n = r.tree.count(snapshot_min_object_size);
+      value.reserve(n);
+      for (uint32_t i = 0; i < n; i++) {
+        typename rd::type row;
+        read_binary_object(r, row);
+        value.push_back(row);
+      }
+    } else if constexpr (rd::disposition == MemberDisposition::MULTIPLE) {
+      uint32_t n = r.tree.count(snapshot_min_object_size);
+      value.reserve(n);
+      for (uint32_t i = 0; i < n; i++)
+        read_binary_object(r, value.emplace_back());
+    }
+  }
+}
+
+template<class Class, size_t ... I>
+void read_binary_object(SnapshotReader& r, Class& object, std::index_sequence<I...>) {
+  (void)r;
+  (void)object;
+  (read_binary_i<Class, I>(r, object),...);
+}
+
+template<class Class>
+void read_binary_object(SnapshotReader& r, Class& object) {
+  size_t begin = r.tree.pos();
+  uint32_t size = r.tree.u32();
+  object._element_ = nullptr;
+  object._parsed_ = r.tree.u32() & 1;
+  if constexpr (ClassReflection<Class>::capture_text) {
+    uint32_t n = r.tree.u32();
+    object._text_ = r.tree.bytes(n);
+    r.tree.skip(dvc::binary_writer::padding(n));
+  }
+  read_binary_object(r, object, std::make_index_sequence<ClassReflection<Class>::num_members>());
+  if (r.tree.pos() - begin != size)
+    r.tree.fail();
+}
+
+// Reads a snapshot written by write_binary, or returns nullopt if it was
+// written for a different schema or source, or is corrupt.  Objects read this
+// way have no source element.
+template<class Class>
+std::optional<Class> read_binary(std::string_view snapshot, std::string_view source = {}) {
+  if (snapshot.size() < snapshot_header_size)
+    return std::nullopt;
+  dvc::binary_reader header(snapshot);
+  if (header.bytes(snapshot_magic.size()) != snapshot_magic ||
+      header.u64() != SchemaHash<Class>::value ||
+      header.u64() != source.size() ||
+      header.u64() != snapshot_hash(snapshot_hash_basis, source) ||
+      header.u64() != snapshot_hash(snapshot_hash_basis,
+                                    snapshot.substr(snapshot_header_size)))
+    return std::nullopt;
+  uint32_t num_strings = header.u32();
+  uint32_t data_size = header.u32();
+  uint32_t tree_size = header.u32();
+  size_t data = header.pos() + 4 * size_t(num_strings);
+  if (4 * size_t(num_strings) + data_size +
+          dvc::binary_writer::padding(data_size) + tree_size !=
+      header.remaining())
+    return std::nullopt;
+
+  std::vector<std::string_view> strings(num_strings);
+  uint32_t begin = 0;
+  for (std::string_view& s : strings) {
+    uint32_t end = header.u32();
+    if (end < begin || end > data_size)
+      return std::nullopt;
+    s = snapshot.substr(data + begin, end - begin);
+    begin = end;
+  }
+  header.skip(data_size + dvc::binary_writer::padding(data_size));
+
+  SnapshotReader r(strings, header.bytes(tree_size));
+  std::optional<Class> object;
+  read_binary_object(r, object.emplace());
+  if (!r.tree.ok() || r.tree.remaining() != 0)
+    return std::nullopt;
+  return object;
+}
+
 }  // namespace relaxng
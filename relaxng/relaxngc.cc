@@ -1,19 +1,22 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
-#include <rapidjson/ostreamwrapper.h>
-#include <rapidjson/writer.h>
+#include <algorithm>
+#include <cctype>
 #include <experimental/filesystem>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <optional>
 #include <set>
 #include <string_view>
-#include <unordered_map>
 
+#include "core/binary.h"
 #include "core/file.h"
 #include "core/json.h"
+#include "core/keywords.h"
 #include "core/parser.h"
 #include "core/scanner.h"
+#include "core/string.h"
 
 struct Token {
   enum Kind {
@@ -37,11 +40,11 @@ struct Token {
   };
 
   Token(Kind kind, size_t line) : kind(kind), line(line){};
-  Token(Kind kind, const std::string& spelling, size_t line)
+  Token(Kind kind, std::string_view spelling, size_t line)
       : kind(kind), spelling(spelling), line(line) {}
 
   Kind kind;
-  std::string spelling;
+  std::string_view spelling;
   size_t line;
 };
 
@@ -100,40 +103,32 @@ std::ostream& operator<<(std::ostream& o, const Token& tok) {
 struct SchemaScanner : dvc::scanner {
   using dvc::scanner::scanner;
 
-  std::string parse_string() {
+  static constexpr dvc::byte_class identifier_chars{
+      {'0', '9'}, {'A', 'Z'}, {'a', 'z'}, {'_', '_'}, {':', ':'}};
+  static constexpr dvc::byte_class newline{{'\n', '\n'}};
+
+  std::string_view parse_string() {
     incr();
-    std::ostringstream oss;
+    size_t begin = pos();
     while (true) {
       char c = pop();
       CHECK(peek() != dvc::scanner::eof);
-      if (c == '"') return oss.str();
-      oss.write(&c, 1);
+      if (c == '"') return substr(begin, pos() - 1 - begin);
     }
   }
 
-  std::string parse_identifier() {
-    std::ostringstream oss;
-  again:
-    char c = peek();
-    if (std::isalnum(c) || c == '_' || c == ':') {
-      incr();
-      oss.write(&c, 1);
-      goto again;
-    }
-    return oss.str();
+  std::string_view parse_identifier() {
+    size_t begin = pos();
+    skip_while(identifier_chars);
+    return substr(begin, pos() - begin);
   }
 
   void skip_whitespace() {
     while (true) {
-      if (std::isspace(peek())) {
-        incr();
-        continue;
-      }
+      skip_while(dvc::whitespace);
 
       if (peek() == '#') {
-        do {
-          incr();
-        } while (peek() != '\n' && peek() != dvc::scanner::eof);
+        skip_until(newline);
         continue;
       }
       return;
@@ -141,16 +136,18 @@ struct SchemaScanner : dvc::scanner {
   }
 
   Token parse_next_token() {
-    static const std::unordered_map<char, Token::Kind> punctuation = {
+    static constexpr dvc::char_table<Token::Kind> punctuation = {
         {'{', Token::LBRACE},   {'}', Token::RBRACE}, {'?', Token::QMARK},
         {'*', Token::ASTERISK}, {'|', Token::VBAR},   {'(', Token::LPAREN},
         {')', Token::RPAREN},   {',', Token::COMMA},  {'=', Token::EQUALS},
         {'&', Token::AMPERSAND}};
-    static const std::unordered_map<std::string, Token::Kind> keywords = {
-        {"element", Token::ELEMENT},
-        {"attribute", Token::ATTRIBUTE},
-        {"namespace", Token::NAMESPACE},
-        {"mixed", Token::MIXED}};
+    static constexpr auto keywords = dvc::make_keyword_table<Token::Kind>(
+        {{"element", Token::ELEMENT},
+         {"attribute", Token::ATTRIBUTE},
+         {"namespace", Token::NAMESPACE},
+         {"mixed", Token::MIXED}});
+    static constexpr dvc::byte_class identifier_start{
+        {'A', 'Z'}, {'a', 'z'}, {'_', '_'}};
 
     skip_whitespace();
 
@@ -160,22 +157,17 @@ struct SchemaScanner : dvc::scanner {
     if (c == dvc::scanner::eof) return {Token::END, l};
 
     // punctuation
-    auto it = punctuation.find(c);
-    if (it != punctuation.end()) {
+    if (std::optional<Token::Kind> kind = punctuation.find(c)) {
       incr();
-      return {it->second, l};
+      return {*kind, l};
     }
 
     if (c == '"') return {Token::STRING, parse_string(), l};
 
-    if (std::isalpha(c) || c == '_') {
-      std::string identifier = parse_identifier();
-      auto it = keywords.find(identifier);
-      if (it != keywords.end()) {
-        return {it->second, identifier, l};
-      } else {
-        return {Token::IDENTIFIER, identifier, l};
-      }
+    if (identifier_start.contains(c)) {
+      std::string_view identifier = parse_identifier();
+      return {keywords.find(identifier).value_or(Token::IDENTIFIER), identifier,
+              l};
     }
 
     LOG(FATAL) << "Unexpected character: " << c << " at line " << l;
@@ -184,13 +176,38 @@ struct SchemaScanner : dvc::scanner {
 
 namespace ast {
 
+struct Attribute;
 struct Element;
 
 enum class MemberDisposition { NONE, OPTIONAL, REQUIRED, MULTIPLE };
 
+// The names that stand for text rather than for a production.
+bool is_builtin_text(const std::string& name) {
+  return name == "text" || name == "xsd:float" || name == "xsd:integer" ||
+         name == "xsd:boolean";
+}
+
+// The type of the value of an attribute: an xsd:integer, an xsd:boolean or a
+// choice of strings ("a" | "b"), or otherwise text.
+struct ValueType {
+  enum Kind { TEXT, INTEGER, BOOLEAN, ENUM };
+  Kind kind = TEXT;
+  // For ENUM, the production that is the choice, if any, and the strings in
+  // schema order.  For BOOLEAN, xsd:boolean if declared so, whose values
+  // may also be spelt "1" and "0".
+  std::string name;
+  std::vector<std::string> values;
+};
+
+bool operator==(const ValueType& a, const ValueType& b) {
+  return a.kind == b.kind && a.name == b.name && a.values == b.values;
+}
+bool operator!=(const ValueType& a, const ValueType& b) { return !(a == b); }
+
 struct MemberDispositions {
   std::map<std::string, MemberDisposition> attributes;
   std::map<std::string, MemberDisposition> elements;
+  std::map<std::string, const Attribute*> pattributes;
   std::map<std::string, const Element*> pelements;
 
   void visit(std::function<void(MemberDisposition&)> f) {
@@ -245,6 +262,8 @@ struct Pattern {
       const Schema& schema) const = 0;
 
   virtual bool is_text(const Schema& schema) const { return false; }
+
+  virtual ValueType value_type(const Schema& schema) const { return {}; }
 };
 
 using PPattern = std::shared_ptr<Pattern>;
@@ -258,6 +277,31 @@ struct Name : Pattern {
       const Schema& schema) const override;
 
   bool is_text(const Schema& schema) const override;
+
+  ValueType value_type(const Schema& schema) const override;
+};
+
+// A string: one of the values that an attribute may take.
+struct Value : Pattern {
+  Value(const std::string& value) : value(value) {}
+  std::string value;
+  void to_json(dvc::json_writer& w) const override {
+    w.start_array();
+    w.write_string(typeid(*this).name());
+    w.write_string(value);
+    w.end_array();
+  }
+
+  MemberDispositions get_member_dispositions(
+      const Schema& schema) const override {
+    return {};
+  }
+
+  bool is_text(const Schema& schema) const override { return true; }
+
+  ValueType value_type(const Schema& schema) const override {
+    return {ValueType::ENUM, "", {value}};
+  }
 };
 
 struct UnaryPattern : Pattern {
@@ -348,6 +392,8 @@ struct Alternate : BinaryPattern {
   using BinaryPattern::BinaryPattern;
   MemberDispositions get_member_dispositions(
       const Schema& schema) const override;
+
+  ValueType value_type(const Schema& schema) const override;
 };
 
 struct Sequence : BinaryPattern {
@@ -366,6 +412,16 @@ struct Attribute : BracedPattern {
   using BracedPattern::BracedPattern;
   MemberDispositions get_member_dispositions(
       const Schema& schema) const override;
+
+  // The type of the attribute's value, with "true" | "false" as BOOLEAN.
+  ValueType type(const Schema& schema) const {
+    ValueType type = pattern->value_type(schema);
+    if (type.kind == ValueType::ENUM &&
+        std::set<std::string>(type.values.begin(), type.values.end()) ==
+            std::set<std::string>{"false", "true"})
+      return {ValueType::BOOLEAN};
+    return type;
+  }
 };
 
 struct Element : BracedPattern {
@@ -395,7 +451,7 @@ struct Schema {
     w.end_object();
   }
 
-  void visit(std::function<bool(const Pattern&)> f) {
+  void visit(std::function<bool(const Pattern&)> f) const {
     for (const auto& [name, pattern] : productions) {
       (void)name;
       pattern->visit(f);
@@ -404,16 +460,38 @@ struct Schema {
 };
 
 bool Name::is_text(const Schema& schema) const {
-  if (name == "text" || name == "xsd:float")
+  if (is_builtin_text(name))
     return true;
   else
     return schema.productions.at(name)->is_text(schema);
 }
 
+ValueType Name::value_type(const Schema& schema) const {
+  if (name == "xsd:integer") return {ValueType::INTEGER};
+  if (name == "xsd:boolean") return {ValueType::BOOLEAN, name};
+  if (is_builtin_text(name)) return {};
+  ValueType type = schema.productions.at(name)->value_type(schema);
+  if (type.kind == ValueType::ENUM && type.name.empty()) type.name = name;
+  return type;
+}
+
+ValueType Alternate::value_type(const Schema& schema) const {
+  ValueType l = left->value_type(schema);
+  ValueType r = right->value_type(schema);
+  if (l.kind != ValueType::ENUM || r.kind != ValueType::ENUM) return {};
+  ValueType type{ValueType::ENUM};
+  for (const ValueType* side : {&l, &r})
+    for (const std::string& value : side->values)
+      if (std::find(type.values.begin(), type.values.end(), value) ==
+          type.values.end())
+        type.values.push_back(value);
+  return type;
+}
+
 MemberDispositions Name::get_member_dispositions(const Schema& schema) const {
   MemberDispositions dispositions;
 
-  if (name == "text" || name == "xsd:float") return dispositions;
+  if (is_builtin_text(name)) return dispositions;
   const Pattern* pattern = schema.productions.at(name).get();
   if (auto element = dynamic_cast<const Element*>(pattern)) {
     dispositions.elements[element->name] = MemberDisposition::REQUIRED;
@@ -502,9 +580,22 @@ MemberDispositions BinaryPattern::get_binary_member_dispositions(
     return result;
   };
 
+  auto ma = [&](const std::map<std::string, const ast::Attribute*>& a,
+                const std::map<std::string, const ast::Attribute*>& b) {
+    std::map<std::string, const ast::Attribute*> result = a;
+    for (const auto& [k, v] : b) {
+      auto [it, inserted] = result.emplace(k, v);
+      if (!inserted && it->second != v)
+        CHECK(it->second->type(schema) == v->type(schema))
+            << "attributes of different types " << k;
+    }
+    return result;
+  };
+
   MemberDispositions dispositions;
   dispositions.attributes = m(l.attributes, r.attributes);
   dispositions.elements = m(l.elements, r.elements);
+  dispositions.pattributes = ma(l.pattributes, r.pattributes);
   dispositions.pelements = mp(l.pelements, r.pelements);
 
   return dispositions;
@@ -600,6 +691,7 @@ MemberDispositions Attribute::get_member_dispositions(
     const Schema& schema) const {
   MemberDispositions dispositions;
   dispositions.attributes[name] = MemberDisposition::REQUIRED;
+  dispositions.pattributes[name] = this;
   return dispositions;
 }
 
@@ -626,6 +718,7 @@ MemberDispositions Element::get_member_dispositions(
 //    element ID { expr }
 //    attribute ID { expr }
 //    ID
+//    STRING
 //    expr ?
 //    expr *
 //    ( expr )
@@ -633,9 +726,9 @@ MemberDispositions Element::get_member_dispositions(
 //    expr , expr
 //    expr & expr
 
-class SchemaParser : public dvc::parser<Token> {
+class SchemaParser : public dvc::stream_parser<Token, SchemaScanner, 1> {
  public:
-  using dvc::parser<Token>::parser;
+  using dvc::stream_parser<Token, SchemaScanner, 1>::stream_parser;
   ast::Schema parse_schema() {
     ast::Schema schema;
 
@@ -659,7 +752,7 @@ class SchemaParser : public dvc::parser<Token> {
     Token key = pop();
     CHECK(key == Token::IDENTIFIER) << "unexpected token: " << key;
     CHECK_EQ(pop(), Token::EQUALS);
-    return {std::move(key.spelling), parse_pattern()};
+    return {std::string(key.spelling), parse_pattern()};
   }
 
   ast::PPattern parse_pattern() {
@@ -677,8 +770,10 @@ class SchemaParser : public dvc::parser<Token> {
       CHECK_EQ(pop(), Token::RPAREN);
     } else if (peek() == Token::IDENTIFIER) {
       pattern = parse_name();
+    } else if (peek() == Token::STRING) {
+      pattern = parse_value();
     } else {
-      LOG(FATAL) << "expected element, attribute, identifier, paren: "
+      LOG(FATAL) << "expected element, attribute, identifier, string, paren: "
                  << peek();
     }
 
@@ -715,7 +810,8 @@ class SchemaParser : public dvc::parser<Token> {
     CHECK_EQ(pop(), Token::LBRACE);
     ast::PPattern pattern = parse_pattern();
     CHECK_EQ(pop(), Token::RBRACE);
-    return std::make_shared<BracedPattern>(id.spelling, std::move(pattern));
+    return std::make_shared<BracedPattern>(std::string(id.spelling),
+                                           std::move(pattern));
   }
 
   ast::PPattern parse_mixed() {
@@ -737,35 +833,454 @@ class SchemaParser : public dvc::parser<Token> {
   ast::PPattern parse_name() {
     Token id = pop();
     CHECK_EQ(id, Token::IDENTIFIER);
-    return std::make_shared<ast::Name>(id.spelling);
+    return std::make_shared<ast::Name>(std::string(id.spelling));
   }
-};
 
-ast::Schema parse_schema(const dvc::fspath& schema_path) {
-  SchemaScanner scanner(schema_path.filename().string(),
-                        dvc::load_file(schema_path));
-  std::vector<Token> tokens;
-  Token token = scanner.parse_next_token();
-  while (true) {
-    tokens.push_back(token);
-    if (token == Token::END) break;
-    token = scanner.parse_next_token();
+  ast::PPattern parse_value() {
+    Token value = pop();
+    CHECK_EQ(value, Token::STRING);
+    return std::make_shared<ast::Value>(std::string(value.spelling));
   }
+};
 
-  //  for (size_t i = 0; i < tokens.size(); i++)
-  //    LOG(INFO) << "token " << i << " = " << tokens.at(i);
-  SchemaParser parser(schema_path.filename().string(), std::move(tokens));
+ast::Schema parse_schema(const dvc::fspath& schema_path,
+                         std::string_view schema) {
+  SchemaScanner scanner(schema_path.filename().string(), schema, dvc::borrow);
+  SchemaParser parser(schema_path.filename().string(), scanner);
   return parser.parse_schema();
 }
 
 DEFINE_string(namespace, "relaxnggen", "namespace to put generated code in");
 DEFINE_string(protocol, "", "protocol name");
+DEFINE_string(capture_text, "",
+              "comma-separated classes whose inner text is captured");
+DEFINE_string(text_skip, "",
+              "element whose text is left out of captured inner text");
+DEFINE_bool(emit_views, false,
+            "also emit a lazy view class, Class_view, for each class");
+DEFINE_string(columnar, "",
+              "comma-separated classes, of only required and optional text "
+              "and attribute members, whose repeated members are stored by "
+              "column, as relaxng::Table");
+DEFINE_string(emit_parser, "",
+              "also write a .cc file here with a parse_element() function "
+              "for each class");
+DEFINE_string(parser_include, "",
+              "how the --emit_parser file includes the generated header; "
+              "defaults to its file name");
+DEFINE_string(cache, "",
+              "Cache of the analysed schema, reused while the schema is "
+              "unchanged, and for each class while the productions it "
+              "reaches are");
+
+// The enumerator for value: value with the characters that cannot be in an
+// identifier replaced by _, and a _ appended to a keyword.
+std::string enumerator_name(const std::string& value) {
+  static const std::set<std::string> keywords = {
+      "auto",     "bool",    "break",    "case",     "char",   "class",
+      "const",    "default", "delete",   "do",       "double", "else",
+      "enum",     "explicit", "extern",  "false",    "float",  "for",
+      "goto",     "if",      "inline",   "int",      "long",   "new",
+      "operator", "private", "protected", "public",  "return", "short",
+      "signed",   "sizeof",  "static",   "struct",   "switch", "template",
+      "this",     "true",    "typedef",  "typename", "union",  "unsigned",
+      "using",    "virtual", "void",     "volatile", "while"};
+  std::string name = value;
+  for (char& c : name)
+    if (!isalnum(uint8_t(c))) c = '_';
+  if (name.empty() || isdigit(uint8_t(name[0]))) name = "_" + name;
+  if (keywords.count(name)) name += "_";
+  return name;
+}
 
-void generate_relaxng_parser(const dvc::fspath& schema_file,
-                             const dvc::fspath& hout) {
-  ast::Schema schema = parse_schema(schema_file);
-  dvc::file_writer w(hout, dvc::truncate);
+struct StructDesign {
+  std::string name;
+
+  struct Member {
+    enum Kind { ATTRIBUTE, SUBELEMENT };
+    std::string type;
+    std::string output_name;
+    Kind kind;
+    std::string input_name;
+    ast::MemberDisposition disposition;
+    // Whether the value is a string or an attribute value rather than a
+    // generated class.
+    bool text;
+    // The type of an attribute's value.
+    ast::ValueType value_type;
+    // The generated class of a subelement that is not text.
+    std::string class_name;
+    // Whether the repeated member is a relaxng::Table (--columnar).
+    bool table = false;
+  };
+
+  std::vector<Member> members;
+
+  std::set<std::string> dependencies;
+
+  // The hash of what the design was analysed from, for --cache.
+  uint64_t key = 0;
+};
+
+// The design of each class, by name, as analysed from the schema: before the
+// flags that change only how the classes are emitted.
+using SchemaDesign = std::map<std::string, StructDesign>;
+
+// The keys of the designs of the classes, for --cache: hashes of what each
+// design depends on.  That is the production that contains the class's
+// element, and the productions that it refers to, transitively, except that
+// of a production that is an element, only whether it is text and the name of
+// its class.  Each production is hashed once.
+class DesignKeys {
+ public:
+  DesignKeys(
+      const ast::Schema& schema,
+      const std::map<const ast::Element*, std::string>& element_type_names)
+      : schema(schema), element_type_names(element_type_names) {
+    for (const auto& [name, pattern] : schema.productions) {
+      Production& production = productions[name];
+      dvc::json_writer w;
+      w.start_array();
+      pattern->to_json(w);
+      pattern->visit([&](const ast::Pattern& p) {
+        if (auto n = dynamic_cast<const ast::Name*>(&p)) {
+          if (!ast::is_builtin_text(n->name)) production.refs.insert(n->name);
+        } else if (auto element = dynamic_cast<const ast::Element*>(&p)) {
+          w.write_string(type_name(element));
+        }
+        return true;
+      });
+      w.end_array();
+      production.hash = dvc::fnv1a(dvc::fnv1a_basis, w.str());
+    }
+  }
+
+  // The key of the class class_name, whose element is in production.
+  uint64_t key(const std::string& class_name,
+               const std::string& production) const {
+    std::string key = class_name;
+    std::set<std::string> reached = {production};
+    std::vector<std::string> todo = {production};
+    while (!todo.empty()) {
+      std::string name = todo.back();
+      todo.pop_back();
+      const Production& p = productions.at(name);
+      key += " " + name + " " + std::to_string(p.hash);
+      for (const std::string& ref : p.refs) {
+        if (!reached.insert(ref).second) continue;
+        auto element =
+            dynamic_cast<const ast::Element*>(schema.productions.at(ref).get());
+        if (element)
+          key += " " + ref + " " +
+                 (element->is_simple(schema) ? "text" : type_name(element));
+        else
+          todo.push_back(ref);
+      }
+    }
+    return dvc::fnv1a(dvc::fnv1a_basis, key);
+  }
+
+ private:
+  struct Production {
+    uint64_t hash;
+    std::set<std::string> refs;
+  };
 
+  std::string type_name(const ast::Element* element) const {
+    auto it = element_type_names.find(element);
+    return it == element_type_names.end() ? "" : it->second;
+  }
+
+  const ast::Schema& schema;
+  const std::map<const ast::Element*, std::string>& element_type_names;
+  std::map<std::string, Production> productions;
+};
+
+// --cache holds the schema's design and what it was analysed from, in the
+// fixed-width little-endian fields of dvc::binary_writer, strings as a u32
+// size and their bytes:
+//
+//   header   "rngcache", u32 cache_version, u64 build id, u64 schema size,
+//            u64 schema hash, u64 hash of the classes, u32 class count
+//   class    name, u64 key, u32 dependency count, dependencies, u32 member
+//            count, members
+//   member   type, output_name, u32 kind, input_name, u32 disposition, u32
+//            text, class_name, u32 value kind, value name, u32 value count,
+//            values
+//
+// Hashes are FNV-1a.  The build id identifies the relaxngc that wrote the
+// cache, so a rebuilt relaxngc, whose analysis may differ, starts afresh.
+// Bump cache_version when the layout changes.
+constexpr std::string_view cache_magic = "rngcache";
+constexpr uint32_t cache_version = 3;
+
+// The build id: the hash of this relaxngc's executable.
+uint64_t cache_build_id() {
+  dvc::mapped_file self =
+      dvc::load_file(dvc::fspath("/proc/self/exe"), dvc::mapped);
+  return dvc::fnv1a(dvc::fnv1a_basis, self);
+}
+
+void write_cache(const dvc::fspath& path, uint64_t build_id,
+                 std::string_view schema, const SchemaDesign& designs) {
+  dvc::binary_writer w;
+  auto string = [&w](std::string_view s) {
+    w.u32(s.size());
+    w.bytes(s);
+  };
+  w.bytes(cache_magic);
+  w.u32(cache_version);
+  w.u64(build_id);
+  w.u64(schema.size());
+  w.u64(dvc::fnv1a(dvc::fnv1a_basis, schema));
+  size_t classes_hash = w.size();
+  w.u64(0);
+  w.u32(designs.size());
+  for (const auto& [name, design] : designs) {
+    string(name);
+    w.u64(design.key);
+    w.u32(design.dependencies.size());
+    for (const std::string& dependency : design.dependencies)
+      string(dependency);
+    w.u32(design.members.size());
+    for (const StructDesign::Member& member : design.members) {
+      string(member.type);
+      string(member.output_name);
+      w.u32(member.kind);
+      string(member.input_name);
+      w.u32(uint32_t(member.disposition));
+      w.u32(member.text);
+      string(member.class_name);
+      w.u32(member.value_type.kind);
+      string(member.value_type.name);
+      w.u32(member.value_type.values.size());
+      for (const std::string& value : member.value_type.values)
+        string(value);
+    }
+  }
+  w.patch_u64(classes_hash,
+              dvc::fnv1a(dvc::fnv1a_basis,
+                         std::string_view(w.str()).substr(classes_hash + 8)));
+  dvc::file_writer file(path, dvc::replace);
+  file.write(w.str());
+}
+
+// The design in the cache at path, and in same_schema whether it was
+// analysed from schema, or nothing if the cache was written by another build
+// or is corrupt.
+SchemaDesign read_cache(const dvc::fspath& path, uint64_t build_id,
+                        std::string_view schema, bool& same_schema) {
+  dvc::mapped_file data = dvc::load_file(path, dvc::mapped);
+  dvc::binary_reader r(data);
+  auto string = [&r] { return std::string(r.bytes(r.u32())); };
+  if (r.bytes(cache_magic.size()) != cache_magic ||
+      r.u32() != cache_version || r.u64() != build_id)
+    return {};
+  uint64_t schema_size = r.u64();
+  uint64_t schema_hash = r.u64();
+  uint64_t classes_hash = r.u64();
+  std::string_view classes = std::string_view(data).substr(r.pos());
+  if (!r.ok() || classes_hash != dvc::fnv1a(dvc::fnv1a_basis, classes)) {
+    LOG(WARNING) << "ignoring corrupt cache " << path;
+    return {};
+  }
+  // The smallest class and member: their fixed-width fields and empty
+  // strings.
+  constexpr size_t min_class_size = 20;
+  constexpr size_t min_member_size = 40;
+  SchemaDesign designs;
+  for (uint32_t num_classes = r.count(min_class_size); num_classes > 0;
+       num_classes--) {
+    std::string name = string();
+    StructDesign& design = designs[name];
+    design.name = name;
+    design.key = r.u64();
+    for (uint32_t n = r.count(4); n > 0; n--)
+      design.dependencies.insert(string());
+    design.members.resize(r.count(min_member_size));
+    for (StructDesign::Member& member : design.members) {
+      member.type = string();
+      member.output_name = string();
+      member.kind = StructDesign::Member::Kind(r.u32());
+      member.input_name = string();
+      member.disposition = ast::MemberDisposition(r.u32());
+      member.text = r.u32();
+      member.class_name = string();
+      member.value_type.kind = ast::ValueType::Kind(r.u32());
+      member.value_type.name = string();
+      for (uint32_t n = r.count(4); n > 0; n--)
+        member.value_type.values.push_back(string());
+    }
+  }
+  if (!r.ok() || r.remaining() != 0) {
+    LOG(WARNING) << "ignoring corrupt cache " << path;
+    return {};
+  }
+  same_schema = schema_size == schema.size() &&
+                schema_hash == dvc::fnv1a(dvc::fnv1a_basis, schema);
+  return designs;
+}
+
+// Writes parse_element() for each class to --emit_parser: the parse that
+// relaxng::parse() instantiates from the reflection, as plain functions.
+void generate_parser(const dvc::fspath& schema_file, const dvc::fspath& hout,
+                     const std::vector<StructDesign>& struct_designs,
+                     const std::set<std::string_view>& capture_text) {
+  dvc::file_writer w(dvc::fspath(FLAGS_emit_parser), dvc::if_changed);
+
+  // Dispatches on the name in `name`: the cases for members, which end in
+  // `continue`, or else falls through to what follows the switch.
+  auto emit_switch = [&w](const std::vector<const StructDesign::Member*>& members,
+                          const std::string& indent, auto emit_member) {
+    std::map<size_t, std::vector<const StructDesign::Member*>> by_size;
+    for (const StructDesign::Member* member : members)
+      by_size[member->input_name.size()].push_back(member);
+    w.println(indent, "switch (name.size()) {");
+    for (const auto& [size, sized_members] : by_size) {
+      w.println(indent, "  case ", size, ":");
+      for (const StructDesign::Member* member : sized_members) {
+        w.println(indent, "    if (name == \"", member->input_name, "\") {");
+        emit_member(*member, indent + "      ");
+        w.println(indent, "      continue;");
+        w.println(indent, "    }");
+      }
+      w.println(indent, "    break;");
+    }
+    w.println(indent, "}");
+  };
+
+  w.println("// autogenerated from ", schema_file);
+  w.println();
+  w.println("#include \"",
+            FLAGS_parser_include.empty() ? hout.filename().string()
+                                         : FLAGS_parser_include,
+            "\"");
+  w.println();
+  w.println("#include <string_view>");
+  w.println("#include <glog/logging.h>");
+  w.println();
+  w.println("namespace ", FLAGS_namespace, " {");
+
+  for (const StructDesign& struct_design : struct_designs) {
+    std::vector<const StructDesign::Member*> attributes;
+    std::vector<const StructDesign::Member*> subelements;
+    std::vector<const StructDesign::Member*> repeated;
+    for (const StructDesign::Member& member : struct_design.members) {
+      if (member.kind == StructDesign::Member::ATTRIBUTE) {
+        attributes.push_back(&member);
+      } else {
+        subelements.push_back(&member);
+        if (member.disposition == ast::MemberDisposition::MULTIPLE)
+          repeated.push_back(&member);
+      }
+    }
+
+    w.println();
+    w.println("void parse_element(", struct_design.name,
+              "& object, ::relaxng::Element element) {");
+    w.println("  object._element_ = element;");
+    w.println("  object._parsed_ = true;");
+    w.println();
+    w.println("  for (::relaxng::Attribute attribute = element->FirstAttribute(); "
+              "attribute != nullptr; attribute = attribute->Next()) {");
+    if (!attributes.empty()) {
+      w.println("    std::string_view name = attribute->Name();");
+      emit_switch(attributes, "    ", [&w](const StructDesign::Member& member,
+                                         const std::string& indent) {
+        if (member.value_type.kind == ast::ValueType::TEXT)
+          w.println(indent, "::relaxng::set_member(object.", member.output_name,
+                    ", attribute->Value());");
+        else
+          w.println(indent, "CHECK(::relaxng::",
+                    member.value_type.name == "xsd:boolean" ? "set_xsd_boolean"
+                                                            : "set_attribute",
+                    "(object.", member.output_name,
+                    ", attribute->Value())) << \"invalid attribute \" << "
+                    "name << \"=\\\"\" << attribute->Value() << \"\\\" line \" "
+                    "<< attribute->GetLineNum();");
+      });
+    }
+    w.println("    LOG(FATAL) << \"unknown attribute \" << attribute->Name() "
+              "<< \" line \" << attribute->GetLineNum();");
+    w.println("  }");
+
+    if (!repeated.empty()) {
+      w.println();
+      w.println("  size_t counts[", repeated.size(), "] = {};");
+      w.println("  for (::relaxng::Element subelement = "
+                "element->FirstChildElement(); subelement != nullptr; "
+                "subelement = subelement->NextSiblingElement()) {");
+      w.println("    std::string_view name = subelement->Name();");
+      for (size_t i = 0; i < repeated.size(); i++)
+        w.println("    ", i == 0 ? "if" : "else if", " (name == \"",
+                  repeated[i]->input_name, "\") counts[", i, "]++;");
+      w.println("  }");
+      for (size_t i = 0; i < repeated.size(); i++)
+        w.println("  if (counts[", i, "] > 0) object.",
+                  repeated[i]->output_name, ".reserve(counts[", i, "]);");
+    }
+
+    if (!subelements.empty()) {
+      w.println();
+      w.println("  for (::relaxng::Element subelement = "
+                "element->FirstChildElement(); subelement != nullptr; "
+                "subelement = subelement->NextSiblingElement()) {");
+      w.println("    std::string_view name = subelement->Name();");
+      emit_switch(subelements, "    ", [&w](const StructDesign::Member& member,
+                                          const std::string& indent) {
+        std::string field = "object." + member.output_name;
+        if (member.text) {
+          w.println(indent, "::relaxng::set_member(", field,
+                    ", subelement->GetText());");
+          return;
+        }
+        switch (member.disposition) {
+          case ast::MemberDisposition::REQUIRED:
+            w.println(indent, "CHECK(!", field, "._parsed_) << \"required "
+                      "member already present \" << name << \" line \" << "
+                      "subelement->GetLineNum();");
+            w.println(indent, "parse_element(", field, ", subelement);");
+            break;
+          case ast::MemberDisposition::OPTIONAL:
+            w.println(indent, "CHECK(!", field, ") << \"optional member "
+                      "already present \" << name << \" line \" << "
+                      "subelement->GetLineNum();");
+            w.println(indent, "parse_element(", field,
+                      ".emplace(), subelement);");
+            break;
+          case ast::MemberDisposition::MULTIPLE:
+            if (member.table) {
+              w.println(indent, member.class_name, " row;");
+              w.println(indent, "parse_element(row, subelement);");
+              w.println(indent, field, ".push_back(row);");
+            } else {
+              w.println(indent, "parse_element(", field,
+                        ".emplace_back(), subelement);");
+            }
+            break;
+          case ast::MemberDisposition::NONE:
+            LOG(FATAL) << "none disposition: " << member.output_name;
+        }
+      });
+      w.println("  }");
+    }
+
+    if (capture_text.count(struct_design.name)) {
+      w.println();
+      w.println("  ::relaxng::append_inner_text(object._text_, element, \"",
+                FLAGS_text_skip, "\");");
+    }
+    w.println("}");
+  }
+
+  w.println();
+  w.println("}  // namespace ", FLAGS_namespace);
+}
+
+// Analyses schema into the design of each class.  With --cache, cached is
+// the design in the cache, and a class whose design is there with the key that
+// it would now have is moved from there rather than analysed again.
+SchemaDesign analyse_schema(const ast::Schema& schema, SchemaDesign* cached) {
   std::map<const ast::Pattern*, std::string> global_pattern_names;
   std::map<std::string, const ast::Pattern*> global_name_patterns;
 
@@ -779,6 +1294,8 @@ void generate_relaxng_parser(const dvc::fspath& schema_file,
 
   std::map<const ast::Element*, std::string> element_type_names;
   std::map<std::string, const ast::Element*> element_name_types;
+  // The production that contains each element.
+  std::map<const ast::Element*, std::string> element_productions;
 
   std::string last_element;
   schema.visit([&](const ast::Pattern& pattern) -> bool {
@@ -795,8 +1312,9 @@ void generate_relaxng_parser(const dvc::fspath& schema_file,
         last_element = type_name;
       } else
         type_name = last_element + "_" + element->name;
+      element_productions[element] = last_element;
       if (auto name = dynamic_cast<const ast::Name*>(element->pattern.get()))
-        if (name->name == "text" || name->name == "xsd:float")
+        if (ast::is_builtin_text(name->name))
           simple_element = true;
       if (simple_element)
         simple_elements.insert(element);
@@ -829,38 +1347,57 @@ void generate_relaxng_parser(const dvc::fspath& schema_file,
     LOG(FATAL) << "none disposition: " << (int)disposition;
   };
 
-  struct StructDesign {
-    std::string name;
-
-    struct Member {
-      enum Kind { ATTRIBUTE, SUBELEMENT };
-      std::string type;
-      std::string output_name;
-      Kind kind;
-      std::string input_name;
-    };
-
-    std::vector<Member> members;
-
-    std::set<std::string> dependencies;
-  };
-
-  std::map<std::string, StructDesign> struct_designs_map;
+  SchemaDesign designs;
+  std::optional<DesignKeys> keys;
+  if (cached) keys.emplace(schema, element_type_names);
+  size_t analysed = 0;
 
   for (const auto& [element_type_name, element] : element_name_types) {
+    uint64_t key = 0;
+    if (keys) {
+      key = keys->key(element_type_name, element_productions.at(element));
+      auto it = cached->find(element_type_name);
+      if (it != cached->end() && it->second.key == key) {
+        designs[element_type_name] = std::move(it->second);
+        continue;
+      }
+    }
+    analysed++;
+
     StructDesign design;
     design.name = element_type_name;
+    design.key = key;
 
     ast::MemberDispositions md = element->get_element_dispositions(schema);
     for (const auto& [attribute, disposition] : md.attributes) {
       std::string name = attribute;
       if (md.elements.count(name)) name += "_attribute";
-      std::string type = "std::string";
+      ast::ValueType value_type = md.pattributes.at(attribute)->type(schema);
+      std::string type;
+      switch (value_type.kind) {
+        case ast::ValueType::TEXT:
+          type = "::relaxng::String";
+          break;
+        case ast::ValueType::INTEGER:
+          type = "int64_t";
+          break;
+        case ast::ValueType::BOOLEAN:
+          type = "bool";
+          break;
+        case ast::ValueType::ENUM:
+          if (value_type.name.empty())
+            value_type.name = element_type_name + "_" + name;
+          type = value_type.name;
+          break;
+      }
       StructDesign::Member member;
       member.type = apply_disposition(type, disposition);
       member.output_name = name;
       member.input_name = attribute;
       member.kind = StructDesign::Member::Kind::ATTRIBUTE;
+      member.disposition = disposition;
+      member.text = true;
+      member.value_type = value_type;
       design.members.push_back(member);
     }
     for (const auto& [subelement_name, disposition] : md.elements) {
@@ -870,48 +1407,119 @@ void generate_relaxng_parser(const dvc::fspath& schema_file,
       if (name == "enum") name = "enum_";
 
       std::string type;
-      if (subelement->is_simple(schema))
-        type = "std::string";
+      bool text = subelement->is_simple(schema);
+      if (text)
+        type = "::relaxng::String";
       else {
         type = element_type_names.at(subelement);
         design.dependencies.insert(type);
       }
+      std::string class_name = text ? "" : type;
       StructDesign::Member member;
       member.type = apply_disposition(type, disposition);
       member.output_name = name;
       member.input_name = subelement_name;
       member.kind = StructDesign::Member::Kind::SUBELEMENT;
+      member.disposition = disposition;
+      member.text = text;
+      member.class_name = class_name;
       design.members.push_back(member);
     }
-    struct_designs_map[design.name] = design;
+    designs[design.name] = std::move(design);
+  }
+  if (cached && analysed < designs.size())
+    LOG(INFO) << "--cache: analysed " << analysed << " of " << designs.size()
+              << " classes";
+  return designs;
+}
+
+void generate_relaxng_parser(const dvc::fspath& schema_file,
+                             const dvc::fspath& hout) {
+  dvc::mapped_file schema = dvc::load_file(schema_file, dvc::mapped);
+  uint64_t build_id = FLAGS_cache.empty() ? 0 : cache_build_id();
+  bool same_schema = false;
+  SchemaDesign struct_designs_map;
+  if (!FLAGS_cache.empty() && exists(dvc::fspath(FLAGS_cache)))
+    struct_designs_map =
+        read_cache(FLAGS_cache, build_id, schema, same_schema);
+  if (struct_designs_map.empty() || !same_schema) {
+    struct_designs_map = analyse_schema(
+        parse_schema(schema_file, schema),
+        FLAGS_cache.empty() ? nullptr : &struct_designs_map);
+    if (!FLAGS_cache.empty())
+      write_cache(FLAGS_cache, build_id, schema, struct_designs_map);
   }
 
-  std::set<std::string> todo;
+  // The enum class of each attribute that is a choice of strings.
+  std::map<std::string, std::vector<std::string>> enums;
+  for (const auto& [name, design] : struct_designs_map)
+    for (const StructDesign::Member& member : design.members)
+      if (member.value_type.kind == ast::ValueType::ENUM) {
+        const ast::ValueType& value_type = member.value_type;
+        auto [it, inserted] = enums.emplace(value_type.name, value_type.values);
+        CHECK(inserted || it->second == value_type.values)
+            << "enum " << value_type.name << " with different values";
+      }
+  for (const auto& [name, values] : enums) {
+    (void)values;
+    CHECK(!struct_designs_map.count(name))
+        << "enum and class of the same name: " << name;
+  }
+
+  std::set<std::string_view> capture_text;
+  if (!FLAGS_capture_text.empty())
+    for (std::string_view name : dvc::split_view(",", FLAGS_capture_text))
+      capture_text.insert(name);
+
+  if (!FLAGS_columnar.empty()) {
+    std::set<std::string> columnar;
+    for (std::string_view name : dvc::split_view(",", FLAGS_columnar)) {
+      auto it = struct_designs_map.find(std::string(name));
+      if (it == struct_designs_map.end())
+        LOG(FATAL) << "--columnar: no class " << name;
+      for (const StructDesign::Member& member : it->second.members)
+        if (!member.text ||
+            member.disposition == ast::MemberDisposition::MULTIPLE)
+          LOG(FATAL) << "--columnar: " << name << "::" << member.output_name
+                     << " is not a required or optional value";
+      if (capture_text.count(name))
+        LOG(FATAL) << "--columnar: " << name << " captures text";
+      columnar.insert(std::string(name));
+    }
+    for (auto& entry : struct_designs_map)
+      for (StructDesign::Member& member : entry.second.members)
+        if (member.disposition == ast::MemberDisposition::MULTIPLE &&
+            columnar.count(member.class_name)) {
+          member.type = "::relaxng::Table<" + member.class_name + ">";
+          member.table = true;
+        }
+  }
 
+  // Orders the classes after the classes of their members, with Kahn's
+  // algorithm.  Of the classes whose dependencies are all ordered, the least
+  // name goes next, so the order is the same whatever the design came from.
+  std::map<std::string, size_t> num_pending;
+  std::map<std::string, std::vector<std::string>> dependents;
+  std::set<std::string> ready;
   for (const auto& [name, struct_design] : struct_designs_map) {
-    (void)struct_design;
-    todo.insert(name);
+    num_pending[name] = struct_design.dependencies.size();
+    for (const std::string& dependency : struct_design.dependencies)
+      dependents[dependency].push_back(name);
+    if (struct_design.dependencies.empty()) ready.insert(name);
   }
 
   std::vector<StructDesign> struct_designs_depord;
-
-outer_loop:
-  while (!todo.empty()) {
-    for (const std::string& name : todo) {
-      const StructDesign& struct_design = struct_designs_map.at(name);
-      bool depsdone = true;
-      for (const std::string& dependency : struct_design.dependencies)
-        if (todo.count(dependency)) {
-          depsdone = false;
-          break;
-        }
-      if (depsdone) {
-        struct_designs_depord.push_back(struct_design);
-        todo.erase(name);  // ATTN: Modifying current loop
-        goto outer_loop;
-      }
-    }
+  while (!ready.empty()) {
+    std::string name = *ready.begin();
+    ready.erase(ready.begin());
+    struct_designs_depord.push_back(std::move(struct_designs_map.at(name)));
+    for (const std::string& dependent : dependents[name])
+      if (--num_pending.at(dependent) == 0) ready.insert(dependent);
   }
+  CHECK_EQ(struct_designs_depord.size(), struct_designs_map.size())
+      << "cyclic class dependencies";
+
+  dvc::file_writer w(hout, dvc::if_changed);
 
   w.println("// autogenerated from ", schema_file);
   w.println();
@@ -928,8 +1536,24 @@ outer_loop:
   w.println("struct ", FLAGS_protocol, "{};");
   w.println();
 
+  for (const auto& [name, values] : enums) {
+    w.println("enum class ", name, " {");
+    std::set<std::string> enumerators;
+    for (const std::string& value : values) {
+      std::string enumerator = enumerator_name(value);
+      CHECK(enumerators.insert(enumerator).second)
+          << "enum " << name << " has two enumerators " << enumerator;
+      w.println("  ", enumerator, ",");
+    }
+    w.println("};");
+    w.println();
+  }
+
   for (const StructDesign& struct_design : struct_designs_depord) {
-    w.println("struct ", struct_design.name, " : ::relaxng::GeneratedClass {");
+    w.println("struct ", struct_design.name, " : ::relaxng::",
+              capture_text.count(struct_design.name) ? "TextClass"
+                                                     : "GeneratedClass",
+              " {");
 
     for (const StructDesign::Member& member : struct_design.members) {
       w.println("  ", member.type, " ", member.output_name, ";");
@@ -937,6 +1561,15 @@ outer_loop:
     w.println("};");
     w.println();
   }
+  if (FLAGS_emit_views) {
+    for (const StructDesign& struct_design : struct_designs_depord)
+      w.println("struct ", struct_design.name, "_view;");
+  }
+  if (!FLAGS_emit_parser.empty()) {
+    for (const StructDesign& struct_design : struct_designs_depord)
+      w.println("void parse_element(", struct_design.name,
+                "& object, ::relaxng::Element element);");
+  }
   w.println();
   w.println("}  // namespace ", FLAGS_namespace);
   w.println();
@@ -945,6 +1578,18 @@ outer_loop:
 
   std::string protocol_qname = "::" + FLAGS_namespace + "::" + FLAGS_protocol;
 
+  for (const auto& [name, values] : enums) {
+    w.println("template<>");
+    w.println("struct EnumReflection<::", FLAGS_namespace, "::", name, "> {");
+    w.println("  static constexpr std::array<std::string_view, ", values.size(),
+              "> names = {");
+    for (const std::string& value : values)
+      w.println("    \"", value, "\",");
+    w.println("  };");
+    w.println("};");
+    w.println();
+  }
+
   w.println("template<>");
   w.println("struct ProtocolReflection<", protocol_qname, "> {");
   w.println("  static constexpr size_t num_classes = ",
@@ -977,6 +1622,15 @@ outer_loop:
     w.println("  static constexpr size_t num_members = ",
               struct_design.members.size(), ";");
     w.println("  static constexpr bool present = true;");
+    if (capture_text.count(struct_design.name)) {
+      w.println("  static constexpr bool capture_text = true;");
+      w.println("  static constexpr std::string_view text_skip = \"",
+                FLAGS_text_skip, "\";");
+    } else {
+      w.println("  static constexpr bool capture_text = false;");
+    }
+    if (FLAGS_emit_views)
+      w.println("  using view = ", class_qname, "_view;");
     w.println("};");
     w.println();
     for (size_t member_index = 0; member_index < struct_design.members.size();
@@ -999,12 +1653,58 @@ outer_loop:
                      ? "MemberKind::ATTRIBUTE"
                      : "MemberKind::SUBELEMENT"),
                 ";");
+      if (member.value_type.name == "xsd:boolean")
+        w.println("  static constexpr bool xsd_boolean = true;");
       w.println("};");
     }
     w.println();
   }
 
   w.println("}  // namespace relaxng");
+  for (std::string_view name : capture_text)
+    if (!struct_designs_map.count(std::string(name)))
+      LOG(FATAL) << "--capture_text: no class " << name;
+
+  if (!enums.empty()) {
+    w.println();
+    w.println("namespace ", FLAGS_namespace, " {");
+    w.println();
+    for (const auto& [name, values] : enums) {
+      (void)values;
+      w.println("inline std::ostream& operator<<(std::ostream& o, ", name,
+                " value) {");
+      w.println("  return o << ::relaxng::enum_name(value);");
+      w.println("}");
+      w.println();
+    }
+    w.println("}  // namespace ", FLAGS_namespace);
+  }
+
+  if (FLAGS_emit_views) {
+    w.println();
+    w.println("namespace ", FLAGS_namespace, " {");
+    w.println();
+    for (const StructDesign& struct_design : struct_designs_depord) {
+      w.println("struct ", struct_design.name, "_view : ::relaxng::View<",
+                struct_design.name, "> {");
+      w.println("  using View::View;");
+      for (size_t member_index = 0; member_index < struct_design.members.size();
+           member_index++) {
+        std::string accessor = struct_design.members.at(member_index).output_name;
+        // Leave the base's accessors visible.
+        if (accessor == "text" || accessor == "parse" || accessor == "get")
+          accessor += "_";
+        w.println("  const auto& ", accessor, "() const { return get<",
+                  member_index, ">(); }");
+      }
+      w.println("};");
+      w.println();
+    }
+    w.println("}  // namespace ", FLAGS_namespace);
+  }
+
+  if (!FLAGS_emit_parser.empty())
+    generate_parser(schema_file, hout, struct_designs_depord, capture_text);
 
   //  w.println("// begin fwd decls");
   //  for (const auto& [element_type_name, element] : element_name_types) {
@@ -1,4 +1,5 @@
 
+#include "core/file.h"
 #include "spock/Engine.h"
 #include "spock/Instance.h"
 #include "spock/Surface.h"
@@ -7,8 +8,6 @@
 #include "SDL2/SDL.h"
 #include "SDL2/SDL_vulkan.h"
 
-#include <experimental/filesystem>
-#include <fstream>
 #include <iostream>
 #include <vector>
 
@@ -16,18 +15,6 @@
 
 #include <glm/glm.hpp>
 
-std::vector<char> slurp_file(const std::experimental::filesystem::path& path) {
-  std::ifstream file;
-  file.exceptions(std::ios::badbit | std::ios::failbit | std::ios::eofbit);
-
-  file.open(path.string(), std::ios::ate | std::ios::binary);
-  size_t n = file.tellg();
-  std::vector<char> buf(n);
-  file.seekg(0);
-  file.read(buf.data(), n);
-  return buf;
-}
-
 struct UniformBufferObject {
   glm::mat4 model;
   glm::mat4 view;
@@ -141,7 +128,7 @@ int main(int argc, char** argv) {
         instance.device.createImageView(image_view_create_info));
   }
 
-  std::vector<char> vert_shader_code = slurp_file("vert.spv");
+  dvc::mapped_file vert_shader_code = dvc::load_file("vert.spv", dvc::mapped);
   vk::ShaderModuleCreateInfo vert_shader_module_create_info;
   vert_shader_module_create_info.setCodeSize(vert_shader_code.size());
   vert_shader_module_create_info.setPCode(
@@ -149,7 +136,7 @@ int main(int argc, char** argv) {
   vk::ShaderModule vert_shader =
       instance.device.createShaderModule(vert_shader_module_create_info);
 
-  std::vector<char> frag_shader_code = slurp_file("frag.spv");
+  dvc::mapped_file frag_shader_code = dvc::load_file("frag.spv", dvc::mapped);
   vk::ShaderModuleCreateInfo frag_shader_module_create_info;
   frag_shader_module_create_info.setCodeSize(frag_shader_code.size());
   frag_shader_module_create_info.setPCode(
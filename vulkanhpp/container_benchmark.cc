@@ -0,0 +1,127 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#include "core/container.h"
+#include "core/file.h"
+
+DEFINE_string(vkxml, "", "vk.xml whose names are used as keys");
+DEFINE_int32(iterations, 20, "Number of runs per measurement");
+
+namespace {
+
+// Every distinct name="..." attribute and <name> element in vk.xml, in order
+// of first appearance: roughly the key set of a vks::Registry.
+std::vector<std::string_view> extract_names(std::string_view xml) {
+  std::vector<std::string_view> names;
+  std::set<std::string_view> seen;
+  auto collect = [&](std::string_view open, char close) {
+    for (size_t pos = xml.find(open); pos != std::string_view::npos;
+         pos = xml.find(open, pos)) {
+      pos += open.size();
+      size_t end = xml.find(close, pos);
+      if (end == std::string_view::npos) break;
+      std::string_view name = xml.substr(pos, end - pos);
+      if (seen.insert(name).second) names.push_back(name);
+    }
+  };
+  collect("name=\"", '"');
+  collect("<name>", '<');
+  return names;
+}
+
+template <typename F>
+void run(const std::string& name, F f) {
+  size_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iterations; i++) checksum += f();
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "  " << name << ": " << elapsed.count() / FLAGS_iterations
+            << " us (" << checksum / FLAGS_iterations << ")" << std::endl;
+}
+
+template <typename Map>
+Map build(const std::vector<std::string_view>& keys) {
+  if constexpr (std::is_same_v<Map, dvc::flat_map<std::string, size_t>>) {
+    // Built in one sort, as a flat_map is meant to be.
+    std::vector<typename Map::value_type> entries;
+    entries.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+      entries.emplace_back(std::string(keys[i]), i);
+    return Map(std::move(entries));
+  }
+  Map m;
+  for (size_t i = 0; i < keys.size(); i++)
+    dvc::insert_or_die(m, std::string(keys[i]), i);
+  return m;
+}
+
+template <typename Map>
+struct has_lookup_type {
+  template <typename M>
+  static std::true_type test(typename M::lookup_type*);
+  template <typename M>
+  static std::false_type test(...);
+  static constexpr bool value = decltype(test<Map>(nullptr))::value;
+};
+
+// Keys arrive as views into the mapped vk.xml; the std containers need a
+// std::string to look them up.
+template <typename Map>
+size_t count(const Map& m, std::string_view key) {
+  if constexpr (has_lookup_type<Map>::value)
+    return m.count(key);
+  else
+    return m.count(std::string(key));
+}
+
+template <typename Map>
+void benchmark(const std::string& name,
+               const std::vector<std::string_view>& keys,
+               const std::vector<std::string>& misses) {
+  std::cout << name << std::endl;
+  run("build", [&] { return build<Map>(keys).size(); });
+  Map m = build<Map>(keys);
+  run("hits", [&] {
+    size_t n = 0;
+    for (std::string_view key : keys) n += count(m, key);
+    return n;
+  });
+  run("misses", [&] {
+    size_t n = 0;
+    for (const std::string& key : misses) n += count(m, key);
+    return n;
+  });
+  run("iterate", [&] {
+    size_t n = 0;
+    for (const auto& [key, value] : m) n += key.size() + value;
+    return n;
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+  dvc::mapped_file vkxml = dvc::load_file(FLAGS_vkxml, dvc::mapped);
+
+  std::vector<std::string_view> keys = extract_names(vkxml);
+  std::vector<std::string> misses;
+  for (std::string_view key : keys) misses.push_back(std::string(key) + "_");
+  std::cout << keys.size() << " keys" << std::endl;
+
+  benchmark<std::map<std::string, size_t>>("std::map", keys, misses);
+  benchmark<std::unordered_map<std::string, size_t>>("std::unordered_map",
+                                                     keys, misses);
+  benchmark<dvc::flat_map<std::string, size_t>>("dvc::flat_map", keys, misses);
+  benchmark<dvc::dense_hash_map<std::string, size_t>>("dvc::dense_hash_map",
+                                                      keys, misses);
+}
@@ -0,0 +1,62 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "core/file.h"
+
+DEFINE_string(vkxml, "", "vk.xml whose lines drive the generated output");
+DEFINE_string(out, "/tmp/file_writer_benchmark.out", "Scratch output file");
+DEFINE_int32(iterations, 10, "Number of times to generate the output");
+
+namespace {
+
+// Emits one generated line per input line, shaped like vkxmlc's test output.
+template <typename Println>
+void generate(std::string_view input, Println println) {
+  size_t line = 0;
+  while (!input.empty()) {
+    size_t eol = input.find('\n');
+    std::string_view text = input.substr(0, eol);
+    println("VKXMLTEST_CHECK_LINE(", line++, ", ", text, ");");
+    if (eol == std::string_view::npos) break;
+    input.remove_prefix(eol + 1);
+  }
+}
+
+// The previous dvc::file_writer: an ofstream flushed by std::endl per line.
+void generate_ofstream(std::string_view input) {
+  std::ofstream ofs;
+  ofs.exceptions(std::ios::badbit | std::ios::failbit | std::ios::eofbit);
+  ofs.open(FLAGS_out, std::ios::binary | std::ios::out | std::ios::trunc);
+  generate(input, [&](auto&&... args) { (ofs << ... << args) << std::endl; });
+}
+
+void generate_file_writer(std::string_view input) {
+  dvc::file_writer w(FLAGS_out, dvc::truncate);
+  generate(input, [&](auto&&... args) { w.println(args...); });
+}
+
+template <typename F>
+void run(const std::string& name, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iterations; i++) f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << name << ": " << elapsed.count() / FLAGS_iterations
+            << " ms per generation" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+  dvc::mapped_file vkxml = dvc::load_file(FLAGS_vkxml, dvc::mapped);
+
+  run("ofstream + std::endl", [&] { generate_ofstream(vkxml); });
+  run("dvc::file_writer", [&] { generate_file_writer(vkxml); });
+}
@@ -0,0 +1,96 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "core/file.h"
+#include "core/json.h"
+#include "core/xml.h"
+#include "vulkanhpp/vulkan_relaxng.h"
+
+DEFINE_string(vkxml, "", "vk.xml to dump and reload");
+DEFINE_string(out, "/tmp/json_benchmark.json", "Scratch output file");
+DEFINE_int32(iterations, 20, "Number of runs per measurement");
+
+namespace {
+
+template <typename F>
+void run(const std::string& name, const std::string& unit, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iterations; i++) f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << name << ": " << elapsed.count() / FLAGS_iterations
+            << " ms per " << unit << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  dvc::mapped_file vkxml = dvc::load_file(FLAGS_vkxml, dvc::mapped);
+  tinyxml2::XMLDocument doc;
+  CHECK(doc.Parse(vkxml.data(), vkxml.size()) == tinyxml2::XML_SUCCESS)
+      << "Unable to parse " << FLAGS_vkxml;
+  auto start = relaxng::parse<vkr::start>(doc.RootElement());
+
+  dvc::json_writer dump;
+  write_json(dump, start);
+  std::string json(dump.str());
+
+  // The reloaded registry must dump to the same JSON.
+  {
+    dvc::json_reader r("vk.json", json);
+    auto reloaded = relaxng::read_json<vkr::start>(r);
+    r.end();
+    dvc::json_writer redump;
+    write_json(redump, reloaded);
+    CHECK(redump.str() == json) << "JSON round trip mismatch";
+  }
+
+  std::string snapshot = relaxng::write_binary(start);
+  std::cout << "JSON " << json.size() / 1024 << " KB, snapshot "
+            << snapshot.size() / 1024 << " KB" << std::endl;
+
+  run("std::ofstream sink", "dump", [&] {
+    std::ofstream ofs(FLAGS_out, std::ios::binary | std::ios::trunc);
+    dvc::json_writer jw(ofs);
+    write_json(jw, start);
+  });
+  run("dvc::file_writer sink", "dump", [&] {
+    dvc::file_writer fw(FLAGS_out, dvc::truncate);
+    dvc::json_writer jw(fw);
+    write_json(jw, start);
+  });
+  run("in-memory buffer", "dump", [&] {
+    dvc::json_writer jw;
+    write_json(jw, start);
+  });
+  run("in-memory buffer, pretty", "dump", [&] {
+    dvc::json_writer jw(true);
+    write_json(jw, start);
+  });
+
+  run("XML load (tinyxml2 + relaxng::parse)", "load", [&] {
+    tinyxml2::XMLDocument d;
+    CHECK(d.Parse(vkxml.data(), vkxml.size()) == tinyxml2::XML_SUCCESS);
+    relaxng::parse<vkr::start>(d.RootElement());
+  });
+  run("XML load (dvc::xml_reader + relaxng::parse)", "load", [&] {
+    dvc::xml_reader r(FLAGS_vkxml, vkxml);
+    relaxng::parse_document<vkr::start>(r);
+  });
+  run("JSON reload (relaxng::read_json)", "load", [&] {
+    dvc::json_reader r("vk.json", json);
+    relaxng::read_json<vkr::start>(r);
+  });
+  run("snapshot write (relaxng::write_binary)", "dump",
+      [&] { relaxng::write_binary(start); });
+  run("snapshot reload (relaxng::read_binary)", "load",
+      [&] { relaxng::read_binary<vkr::start>(snapshot); });
+}
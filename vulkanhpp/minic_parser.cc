@@ -1,7 +1,8 @@
 #include "minic_parser.h"
 
-#include <unordered_map>
+#include <optional>
 
+#include "core/keywords.h"
 #include "core/parser.h"
 #include "core/scanner.h"
 
@@ -30,11 +31,11 @@ struct Token {
   };
 
   Token(Kind kind, size_t line) : kind(kind), line(line){};
-  Token(Kind kind, const std::string& spelling, size_t line)
+  Token(Kind kind, std::string_view spelling, size_t line)
       : kind(kind), spelling(spelling), line(line) {}
 
   Kind kind;
-  std::string spelling;
+  std::string_view spelling;
   size_t line;
 };
 
@@ -84,48 +85,35 @@ std::ostream& operator<<(std::ostream& o, const Token& tok) {
 struct CScanner : dvc::scanner {
   using dvc::scanner::scanner;
 
-  std::string parse_identifier() {
-    std::ostringstream oss;
-  again:
-    char c = peek();
-    if (std::isalnum(c) || c == '_') {
-      incr();
-      oss.write(&c, 1);
-      goto again;
-    }
-    return oss.str();
-  }
+  static constexpr dvc::byte_class identifier_chars{
+      {'0', '9'}, {'A', 'Z'}, {'a', 'z'}, {'_', '_'}};
 
-  std::string parse_number() {
-    std::ostringstream oss;
-  again:
-    char c = peek();
-    if (std::isalnum(c) || c == '_') {
-      incr();
-      oss.write(&c, 1);
-      goto again;
-    }
-    return oss.str();
+  std::string_view parse_identifier() {
+    size_t begin = pos();
+    skip_while(identifier_chars);
+    return substr(begin, pos() - begin);
   }
 
-  void skip_whitespace() {
-    while (true) {
-      if (std::isspace(peek())) {
-        incr();
-        continue;
-      }
-      return;
-    }
+  std::string_view parse_number() {
+    size_t begin = pos();
+    skip_while(identifier_chars);
+    return substr(begin, pos() - begin);
   }
 
+  void skip_whitespace() { skip_while(dvc::whitespace); }
+
   Token parse_next_token() {
-    static const std::unordered_map<char, Token::Kind> punctuation = {
+    static constexpr dvc::char_table<Token::Kind> punctuation = {
         {'[', Token::LBRACK},   {']', Token::RBRACK}, {'*', Token::ASTERISK},
         {'(', Token::LPAREN},   {')', Token::RPAREN}, {',', Token::COMMA},
         {';', Token::SEMICOLON}};
 
-    static const std::unordered_map<std::string, Token::Kind> keywords = {
-        {"const", Token::CONST}, {"struct", Token::STRUCT}};
+    static constexpr auto keywords = dvc::make_keyword_table<Token::Kind>(
+        {{"const", Token::CONST}, {"struct", Token::STRUCT}});
+
+    static constexpr dvc::byte_class digits{{'0', '9'}};
+    static constexpr dvc::byte_class identifier_start{
+        {'A', 'Z'}, {'a', 'z'}, {'_', '_'}};
 
     skip_whitespace();
 
@@ -135,24 +123,19 @@ struct CScanner : dvc::scanner {
     if (c == dvc::scanner::eof) return {Token::END, l};
 
     // punctuation
-    auto it = punctuation.find(c);
-    if (it != punctuation.end()) {
+    if (std::optional<Token::Kind> kind = punctuation.find(c)) {
       incr();
-      return {it->second, l};
+      return {*kind, l};
     }
 
-    if (std::isdigit(c)) {
+    if (digits.contains(c)) {
       return {Token::NUMBER, parse_number(), l};
     }
 
-    if (std::isalpha(c) || c == '_') {
-      std::string identifier = parse_identifier();
-      auto it = keywords.find(identifier);
-      if (it != keywords.end()) {
-        return {it->second, identifier, l};
-      } else {
-        return {Token::IDENTIFIER, identifier, l};
-      }
+    if (identifier_start.contains(c)) {
+      std::string_view identifier = parse_identifier();
+      return {keywords.find(identifier).value_or(Token::IDENTIFIER), identifier,
+              l};
     }
 
     LOG(ERROR) << "While parsing " << get_data();
@@ -160,9 +143,11 @@ struct CScanner : dvc::scanner {
   }
 };
 
-class CParser : public dvc::parser<Token> {
+class CParser : public dvc::stream_parser<Token, CScanner, 2> {
  public:
-  using dvc::parser<Token>::parser;
+  CParser(const std::string& filename, CScanner& scanner, dvc::arena& arena)
+      : dvc::stream_parser<Token, CScanner, 2>(filename, scanner),
+        arena(arena) {}
 
   Declaration parse_declaration_end() {
     Declaration decl = parse_declaration();
@@ -171,7 +156,7 @@ class CParser : public dvc::parser<Token> {
   }
 
   Declaration parse_declaration() {
-    std::optional<std::string> root;
+    std::optional<std::string_view> root;
     bool const_ = false;
     while (true) {
       switch (peek().kind) {
@@ -195,33 +180,33 @@ class CParser : public dvc::parser<Token> {
     }
   done_specifiers:;
 
-    Type* t = new Name(root.value());
+    Type* t = arena.make<Name>(root.value());
 
-    if (const_) t = new Const(t);
+    if (const_) t = arena.make<Const>(t);
 
     while (peek() == Token::ASTERISK) {
-      t = new Pointer(t);
+      t = arena.make<Pointer>(t);
       incr();
       if (peek() == Token::CONST) {
-        t = new Const(t);
+        t = arena.make<Const>(t);
         incr();
       }
     }
 
     CHECK(peek() == Token::IDENTIFIER);
-    std::string name = pop().spelling;
+    std::string name(pop().spelling);
 
     if (peek() == Token::LBRACK) {
       incr();
       Expr* e;
       CHECK(peek() == Token::IDENTIFIER || peek() == Token::NUMBER);
       if (peek() == Token::IDENTIFIER) {
-        e = new Reference(pop().spelling);
+        e = arena.make<Reference>(pop().spelling);
       } else {
-        e = new Number(pop().spelling);
+        e = arena.make<Number>(pop().spelling);
       }
       CHECK(pop() == Token::RBRACK);
-      t = new Array(t, e);
+      t = arena.make<Array>(t, e);
     }
 
     return Declaration{name, t};
@@ -231,9 +216,9 @@ class CParser : public dvc::parser<Token> {
     FunctionPrototype function_prototype;
     CHECK(pop().spelling == "typedef");
     CHECK(peek() == Token::IDENTIFIER);
-    Type* t = new Name(pop().spelling);
+    Type* t = arena.make<Name>(pop().spelling);
     if (peek() == Token::ASTERISK) {
-      t = new Pointer(t);
+      t = arena.make<Pointer>(t);
       incr();
     }
 
@@ -265,29 +250,26 @@ class CParser : public dvc::parser<Token> {
     }
     return function_prototype;
   };
+
+ private:
+  dvc::arena& arena;
 };
 
 template <typename F>
-auto parse(const std::string& code, F f) {
-  CScanner scanner("vk.xml", code);
-  std::vector<Token> tokens;
-  while (true) {
-    Token token = scanner.parse_next_token();
-    tokens.push_back(token);
-    if (token == Token::END) break;
-  }
-
-  CParser parser("vk.xml", tokens);
+auto parse(const std::string& code, dvc::arena& arena, F f) {
+  CScanner scanner("vk.xml", code, dvc::borrow);
+  CParser parser("vk.xml", scanner, arena);
 
   return (parser.*f)();
 }
 
-Declaration parse_declaration(const std::string& code) {
-  return parse(code, &CParser::parse_declaration_end);
+Declaration parse_declaration(const std::string& code, dvc::arena& arena) {
+  return parse(code, arena, &CParser::parse_declaration_end);
 }
 
-FunctionPrototype parse_function_prototype(const std::string& code) {
-  return parse(code, &CParser::parse_function_prototype);
+FunctionPrototype parse_function_prototype(const std::string& code,
+                                           dvc::arena& arena) {
+  return parse(code, arena, &CParser::parse_function_prototype);
 }
 
 }  // namespace mnc
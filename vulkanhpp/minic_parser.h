@@ -1,26 +1,29 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "core/arena.h"
+
 namespace mnc {
 
 struct Expr { virtual ~Expr() = default; };
 
 struct Reference : Expr {
-  Reference(const std::string& name) : name(name) {}
+  Reference(std::string_view name) : name(name) {}
   std::string name;
 };
 
 struct Number : Expr {
-  Number(const std::string& number) : number(number) {}
+  Number(std::string_view number) : number(number) {}
   std::string number;
 };
 
 struct Type { virtual ~Type() = default; };
 
 struct Name : Type {
-  Name(const std::string& name) : name(name) {}
+  Name(std::string_view name) : name(name) {}
   std::string name;
 };
 
@@ -51,7 +54,9 @@ struct FunctionPrototype {
   std::vector<Declaration> params;
 };
 
-Declaration parse_declaration(const std::string&);
-FunctionPrototype parse_function_prototype(const std::string&);
+// Nodes of the returned type trees are allocated in `arena`.
+Declaration parse_declaration(const std::string& code, dvc::arena& arena);
+FunctionPrototype parse_function_prototype(const std::string& code,
+                                           dvc::arena& arena);
 
 }  // namespace mnc
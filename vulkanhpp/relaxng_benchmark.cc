@@ -0,0 +1,71 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <chrono>
+#include <iostream>
+
+#include "core/file.h"
+#include "core/string.h"
+#include "core/thread_pool.h"
+#include "core/xml.h"
+#include "vulkanhpp/vulkan_relaxng.h"
+
+DEFINE_string(vkxml, "", "Comma-separated vk.xml files to parse");
+DEFINE_int32(iterations, 20, "Number of runs per measurement");
+DEFINE_int32(threads, 0, "Threads for the parallel parse; 0 for one per core");
+
+namespace {
+
+template <typename F>
+void run(const std::string& name, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iterations; i++) f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "  " << name << ": " << elapsed.count() / FLAGS_iterations
+            << " ms" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  dvc::thread_pool pool = FLAGS_threads > 0 ? dvc::thread_pool(FLAGS_threads)
+                                            : dvc::thread_pool();
+
+  for (std::string_view filename : dvc::split_view(",", FLAGS_vkxml)) {
+    std::string path(filename);
+    dvc::mapped_file vkxml = dvc::load_file(path, dvc::mapped);
+    std::cout << path << std::endl;
+
+    tinyxml2::XMLDocument doc;
+    CHECK(doc.Parse(vkxml.data(), vkxml.size()) == tinyxml2::XML_SUCCESS)
+        << "Unable to parse " << path;
+    run("relaxng::parse<vkr::start>(Element)",
+        [&] { relaxng::parse<vkr::start>(doc.RootElement()); });
+
+    run("vkr::parse_element(vkr::start&, Element)", [&] {
+      vkr::start start;
+      vkr::parse_element(start, doc.RootElement());
+    });
+
+    run("relaxng::parse_parallel<vkr::start>(Element), " +
+            std::to_string(pool.size()) + " threads",
+        [&] { relaxng::parse_parallel<vkr::start>(doc.RootElement(), pool); });
+
+    run("relaxng::parse_document<vkr::start>(xml_reader)", [&] {
+      dvc::xml_reader r(path, vkxml);
+      relaxng::parse_document<vkr::start>(r);
+    });
+
+    // Reading the events alone: the floor for the streaming parse.
+    run("dvc::xml_reader events only", [&] {
+      dvc::xml_reader r(path, vkxml);
+      while (r.next() != dvc::xml_reader::END_DOCUMENT) {
+      }
+    });
+  }
+}
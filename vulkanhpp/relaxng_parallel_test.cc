@@ -0,0 +1,47 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "core/file.h"
+#include "core/json.h"
+#include "core/string.h"
+#include "core/thread_pool.h"
+#include "vulkanhpp/vulkan_relaxng.h"
+
+DEFINE_string(vkxml, "", "Comma-separated vk.xml files to parse");
+
+// The parallel parse must build exactly the tree the sequential one does,
+// whatever the fan-out depth and number of threads.
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  for (std::string_view filename : dvc::split_view(",", FLAGS_vkxml)) {
+    std::string path(filename);
+    dvc::mapped_file vkxml = dvc::load_file(path, dvc::mapped);
+    tinyxml2::XMLDocument doc;
+    CHECK(doc.Parse(vkxml.data(), vkxml.size()) == tinyxml2::XML_SUCCESS)
+        << "Unable to parse " << path;
+
+    auto sequential = relaxng::parse<vkr::start>(doc.RootElement());
+    dvc::json_writer expected;
+    write_json(expected, sequential);
+
+    for (size_t num_threads : {1, 2, 8}) {
+      dvc::thread_pool pool(num_threads);
+      for (size_t levels : {1, 2, 3}) {
+        auto parallel =
+            relaxng::parse_parallel<vkr::start>(doc.RootElement(), pool, levels);
+        CHECK(relaxng::equal(sequential, parallel))
+            << path << ": " << num_threads << " threads, " << levels
+            << " levels";
+        dvc::json_writer actual;
+        write_json(actual, parallel);
+        CHECK(actual.str() == expected.str())
+            << path << ": " << num_threads << " threads, " << levels
+            << " levels";
+      }
+    }
+  }
+}
@@ -0,0 +1,36 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "core/file.h"
+#include "core/json.h"
+#include "core/string.h"
+#include "vulkanhpp/vulkan_relaxng.h"
+
+DEFINE_string(vkxml, "", "Comma-separated vk.xml files to parse");
+
+// The parser relaxngc generates with --emit_parser must build exactly the
+// tree that relaxng::parse() instantiates from the reflection.
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  for (std::string_view filename : dvc::split_view(",", FLAGS_vkxml)) {
+    std::string path(filename);
+    dvc::mapped_file vkxml = dvc::load_file(path, dvc::mapped);
+    tinyxml2::XMLDocument doc;
+    CHECK(doc.Parse(vkxml.data(), vkxml.size()) == tinyxml2::XML_SUCCESS)
+        << "Unable to parse " << path;
+
+    auto expected = relaxng::parse<vkr::start>(doc.RootElement());
+    vkr::start generated;
+    vkr::parse_element(generated, doc.RootElement());
+    CHECK(relaxng::equal(generated, expected)) << path;
+
+    dvc::json_writer expected_json, generated_json;
+    write_json(expected_json, expected);
+    write_json(generated_json, generated);
+    CHECK(generated_json.str() == expected_json.str()) << path;
+  }
+}
@@ -0,0 +1,80 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <random>
+
+#include "core/file.h"
+#include "core/json.h"
+#include "core/string.h"
+#include "core/xml.h"
+#include "vulkanhpp/vulkan_relaxng.h"
+
+DEFINE_string(vkxml, "", "Comma-separated vk.xml files to parse");
+
+namespace {
+
+// Recomputes the hash of the strings and tree, the u64 at offset 32.
+void rehash(std::string& snapshot) {
+  uint64_t h = relaxng::snapshot_hash(
+      relaxng::snapshot_hash_basis,
+      std::string_view(snapshot).substr(relaxng::snapshot_header_size));
+  for (int i = 0; i < 8; i++) snapshot[32 + i] = char(h >> (8 * i));
+}
+
+}  // namespace
+
+// A snapshot must reload to the tree it was written from, and a stale,
+// truncated or corrupt one must be rejected rather than crash the reader.
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  for (std::string_view filename : dvc::split_view(",", FLAGS_vkxml)) {
+    std::string path(filename);
+    dvc::mapped_file vkxml = dvc::load_file(path, dvc::mapped);
+    dvc::xml_reader reader(path, vkxml);
+    auto start = relaxng::parse_document<vkr::start>(reader);
+    std::string snapshot = relaxng::write_binary(start, vkxml);
+
+    auto reloaded = relaxng::read_binary<vkr::start>(snapshot, vkxml);
+    CHECK(reloaded && relaxng::equal(*reloaded, start)) << path;
+    dvc::json_writer expected, actual;
+    write_json(expected, start);
+    write_json(actual, *reloaded);
+    CHECK(actual.str() == expected.str()) << path;
+
+    // Written from other input.
+    std::string edited(vkxml);
+    edited[edited.size() / 2] ^= 1;
+    CHECK(!relaxng::read_binary<vkr::start>(snapshot, edited)) << path;
+    CHECK(!relaxng::read_binary<vkr::start>(snapshot, "")) << path;
+
+    for (size_t size = 0; size < snapshot.size(); size += 997)
+      CHECK(!relaxng::read_binary<vkr::start>(snapshot.substr(0, size), vkxml))
+          << path << ": truncated to " << size;
+    CHECK(!relaxng::read_binary<vkr::start>(snapshot + '\0', vkxml)) << path;
+
+    // Any corrupt byte is caught by the hashes or the header checks.
+    std::mt19937 rng(1);
+    for (size_t i = 0; i < 300; i++) {
+      std::string corrupt = snapshot;
+      size_t pos =
+          i < relaxng::snapshot_header_size ? i : rng() % corrupt.size();
+      corrupt[pos] ^= char(1 + rng() % 255);
+      CHECK(!relaxng::read_binary<vkr::start>(corrupt, vkxml))
+          << path << ": corrupt byte " << pos;
+    }
+
+    // With the hash patched to match, corrupt strings or a corrupt tree must
+    // still not crash the reader, though they may read as some other tree.
+    size_t body = snapshot.size() - relaxng::snapshot_header_size;
+    for (int i = 0; i < 300; i++) {
+      std::string corrupt = snapshot;
+      corrupt[relaxng::snapshot_header_size + rng() % body] ^=
+          char(1 + rng() % 255);
+      rehash(corrupt);
+      relaxng::read_binary<vkr::start>(corrupt, vkxml);
+    }
+  }
+}
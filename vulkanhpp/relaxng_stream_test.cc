@@ -0,0 +1,36 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "core/file.h"
+#include "core/json.h"
+#include "core/string.h"
+#include "core/xml.h"
+#include "vulkanhpp/vulkan_relaxng.h"
+
+DEFINE_string(vkxml, "", "Comma-separated vk.xml files to parse");
+
+// The streaming backend must build exactly the tree the DOM one does.
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  for (std::string_view filename : dvc::split_view(",", FLAGS_vkxml)) {
+    std::string path(filename);
+    dvc::mapped_file vkxml = dvc::load_file(path, dvc::mapped);
+    tinyxml2::XMLDocument doc;
+    CHECK(doc.Parse(vkxml.data(), vkxml.size()) == tinyxml2::XML_SUCCESS)
+        << "Unable to parse " << path;
+    auto dom = relaxng::parse<vkr::start>(doc.RootElement());
+
+    dvc::xml_reader r(path, vkxml);
+    auto streamed = relaxng::parse_document<vkr::start>(r);
+    CHECK(relaxng::equal(dom, streamed)) << path;
+
+    dvc::json_writer expected, actual;
+    write_json(expected, dom);
+    write_json(actual, streamed);
+    CHECK(actual.str() == expected.str()) << path;
+  }
+}
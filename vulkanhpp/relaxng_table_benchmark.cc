@@ -0,0 +1,151 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "core/file.h"
+#include "core/xml.h"
+#include "vulkanhpp/vulkan_relaxng.h"
+
+DEFINE_string(vkxml, "", "vk.xml whose enums are measured");
+DEFINE_int32(iterations, 200, "Number of runs per measurement");
+
+// Compares the vkr::Enum members of a registry stored as rows, the
+// std::vector<vkr::Enum> that relaxngc emits by default, with the same
+// members stored by column, as the relaxng::Table that --columnar emits.
+
+namespace {
+
+size_t allocated_bytes = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocated_bytes += size;
+  if (void* p = std::malloc(size)) return p;
+  throw std::bad_alloc();
+}
+
+// Not inlined, or GCC pairs the std::free with the operator new it replaces
+// and reports a mismatched deallocation.
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+  std::free(p);
+}
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+using Rows = std::vector<vkr::Enum>;
+using Columns = relaxng::Table<vkr::Enum>;
+
+// Every list of enums in the registry, in document order.
+template <typename F>
+void foreach_enums(const vkr::start& start, F f) {
+  for (const auto& enums : start.enums) f(enums.enum_);
+  for (const auto& feature : start.feature)
+    for (const auto& require : feature.require) f(require.enum_);
+  for (const auto& extensions : start.extensions)
+    for (const auto& extension : extensions.extension)
+      for (const auto& require : extension.require) f(require.enum_);
+}
+
+// The heap bytes that building each list with build() allocates in all.
+template <typename Container, typename F>
+std::vector<Container> copy(const vkr::start& start, size_t& bytes, F build) {
+  std::vector<Container> copies;
+  copies.reserve(1000);
+  size_t before = allocated_bytes;
+  foreach_enums(start, [&](const Columns& enums) {
+    copies.push_back(build(enums));
+  });
+  bytes = allocated_bytes - before;
+  return copies;
+}
+
+// What parse_constants reads of each enum: its name, and which of the value
+// attributes it has.
+size_t scan(const std::vector<Rows>& lists) {
+  size_t checksum = 0;
+  for (const Rows& enums : lists)
+    for (const vkr::Enum& enum_ : enums) {
+      checksum += enum_.name.size();
+      if (enum_.value) checksum += 1;
+      else if (enum_.bitpos) checksum += 2;
+      else if (enum_.alias) checksum += 3;
+      else if (enum_.offset) checksum += 4;
+    }
+  return checksum;
+}
+
+size_t scan(const std::vector<Columns>& lists) {
+  size_t checksum = 0;
+  for (const Columns& enums : lists)
+    for (size_t i = 0; i < enums.size(); i++) {
+      checksum += enums.get<&vkr::Enum::name>(i).size();
+      if (enums.has<&vkr::Enum::value>(i)) checksum += 1;
+      else if (enums.has<&vkr::Enum::bitpos>(i)) checksum += 2;
+      else if (enums.has<&vkr::Enum::alias>(i)) checksum += 3;
+      else if (enums.has<&vkr::Enum::offset>(i)) checksum += 4;
+    }
+  return checksum;
+}
+
+template <typename F>
+void run(const std::string& name, F f) {
+  size_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iterations; i++) checksum += f();
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "  " << name << ": " << elapsed.count() / FLAGS_iterations
+            << " us (" << checksum / FLAGS_iterations << ")" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  dvc::mapped_file vkxml = dvc::load_file(FLAGS_vkxml, dvc::mapped);
+  dvc::xml_reader r(FLAGS_vkxml, vkxml);
+  auto start = relaxng::parse_document<vkr::start>(r);
+
+  size_t row_bytes, column_bytes;
+  auto rows = copy<Rows>(start, row_bytes, [](const Columns& enums) {
+    Rows copy;
+    copy.reserve(enums.size());
+    for (const vkr::Enum& enum_ : enums) copy.push_back(enum_);
+    return copy;
+  });
+  auto columns = copy<Columns>(start, column_bytes, [](const Columns& enums) {
+    Columns copy;
+    copy.reserve(enums.size());
+    for (const vkr::Enum& enum_ : enums) copy.push_back(enum_);
+    return copy;
+  });
+
+  size_t n = 0;
+  for (const Rows& enums : rows) n += enums.size();
+  std::cout << FLAGS_vkxml << ": " << n << " enums in " << rows.size()
+            << " lists, " << sizeof(vkr::Enum) << " bytes per row"
+            << std::endl;
+  std::cout << "  std::vector<vkr::Enum>: " << row_bytes << " bytes"
+            << std::endl;
+  std::cout << "  relaxng::Table<vkr::Enum>: " << column_bytes << " bytes"
+            << std::endl;
+
+  // Read through volatile pointers, so that the scans are not hoisted out
+  // of the timing loop.
+  const auto* volatile rows_ptr = &rows;
+  const auto* volatile columns_ptr = &columns;
+  CHECK_EQ(scan(rows), scan(columns));
+  run("scan std::vector<vkr::Enum>", [&] { return scan(*rows_ptr); });
+  run("scan relaxng::Table<vkr::Enum>", [&] { return scan(*columns_ptr); });
+}
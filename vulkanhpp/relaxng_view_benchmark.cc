@@ -0,0 +1,110 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <sys/resource.h>
+#include <chrono>
+#include <iostream>
+
+#include "core/file.h"
+#include "core/xml.h"
+#include "vulkanhpp/vulkan_relaxng.h"
+
+DEFINE_string(vkxml, "", "vk.xml to query");
+DEFINE_string(path, "view",
+              "How to load the registry: dom (tinyxml2 and relaxng::parse), "
+              "stream (relaxng::parse_document) or view (lazy views)");
+DEFINE_int32(iterations, 20, "Number of runs to average");
+
+// A commands-only query: what a loader generator reads of each command.
+// Peak RSS is per process, so each path is measured in a run of its own.
+
+namespace {
+
+struct Summary {
+  size_t commands = 0;
+  size_t params = 0;
+  size_t bytes = 0;
+
+  bool operator==(const Summary& that) const {
+    return commands == that.commands && params == that.params &&
+           bytes == that.bytes;
+  }
+};
+
+template <typename Start>
+Summary query(const Start& start) {
+  Summary summary;
+  for (const auto& commands : start.commands) {
+    for (const auto& command : commands.command) {
+      summary.commands++;
+      if (command.name) summary.bytes += command.name->size();
+      if (command.proto) summary.bytes += command.proto->_text_.size();
+      for (const auto& param : command.param) {
+        summary.params++;
+        summary.bytes += param._text_.size();
+      }
+    }
+  }
+  return summary;
+}
+
+Summary query(const vkr::start_view& start) {
+  Summary summary;
+  for (const auto& commands : start.commands()) {
+    for (const auto& command : commands.command()) {
+      summary.commands++;
+      if (command.name()) summary.bytes += command.name()->size();
+      if (command.proto()) summary.bytes += command.proto()->text().size();
+      for (const auto& param : command.param()) {
+        summary.params++;
+        summary.bytes += param.text().size();
+      }
+    }
+  }
+  return summary;
+}
+
+Summary run_once(const dvc::mapped_file& vkxml) {
+  if (FLAGS_path == "dom") {
+    tinyxml2::XMLDocument doc;
+    CHECK(doc.Parse(vkxml.data(), vkxml.size()) == tinyxml2::XML_SUCCESS)
+        << "Unable to parse " << FLAGS_vkxml;
+    return query(relaxng::parse<vkr::start>(doc.RootElement()));
+  }
+  if (FLAGS_path == "stream") {
+    dvc::xml_reader r(FLAGS_vkxml, vkxml);
+    return query(relaxng::parse_document<vkr::start>(r));
+  }
+  CHECK(FLAGS_path == "view") << "unknown --path " << FLAGS_path;
+  relaxng::ViewSource source{FLAGS_vkxml, vkxml};
+  return query(relaxng::view_document<vkr::start_view>(source));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  dvc::mapped_file vkxml = dvc::load_file(FLAGS_vkxml, dvc::mapped);
+
+  auto start = std::chrono::steady_clock::now();
+  Summary summary = run_once(vkxml);
+  std::chrono::duration<double, std::milli> first =
+      std::chrono::steady_clock::now() - start;
+  for (int i = 1; i < FLAGS_iterations; i++)
+    CHECK(run_once(vkxml) == summary);
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  rusage usage;
+  CHECK_EQ(getrusage(RUSAGE_SELF, &usage), 0);
+  std::cout << FLAGS_path << ": " << summary.commands << " commands, "
+            << summary.params << " params, " << summary.bytes << " bytes"
+            << std::endl;
+  std::cout << "  first run: " << first.count() << " ms" << std::endl;
+  std::cout << "  mean: " << elapsed.count() / FLAGS_iterations << " ms"
+            << std::endl;
+  std::cout << "  peak RSS: " << usage.ru_maxrss << " KB" << std::endl;
+}
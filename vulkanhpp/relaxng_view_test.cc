@@ -0,0 +1,306 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "core/file.h"
+#include "core/string.h"
+#include "core/xml.h"
+#include "vulkanhpp/vulkan_relaxng.h"
+
+DEFINE_string(vkxml, "", "Comma-separated vk.xml files to view");
+
+// Lazy views must read what the eager parse does: View::parse() builds the
+// same object, and each accessor returns the member of that object.
+
+namespace {
+
+#define CHECK_MEMBER(view, object, member) \
+  CHECK((view).member() == (object).member) << #member
+
+template<class View, class Class>
+void check_parse(const View& view, const Class& object) {
+  CHECK(relaxng::equal(view.parse(), object));
+}
+
+template<class View, class Class, typename F>
+void check_each(const std::vector<View>& views, const Class& objects, F f) {
+  CHECK_EQ(views.size(), objects.size());
+  for (size_t i = 0; i < views.size(); i++) f(views[i], objects[i]);
+}
+
+void check(const vkr::Commands_view& view, const vkr::Commands& object) {
+  CHECK_MEMBER(view, object, comment);
+  check_each(view.command(), object.command, [](const auto& v, const auto& o) {
+    CHECK_MEMBER(v, o, alias_attribute);
+    CHECK_MEMBER(v, o, cmdbufferlevel);
+    CHECK_MEMBER(v, o, comment);
+    CHECK_MEMBER(v, o, errorcodes);
+    CHECK_MEMBER(v, o, name);
+    CHECK_MEMBER(v, o, pipeline);
+    CHECK_MEMBER(v, o, queues);
+    CHECK_MEMBER(v, o, renderpass);
+    CHECK_MEMBER(v, o, successcodes);
+    CHECK_MEMBER(v, o, description);
+    CHECK_EQ(v.alias_subelement().has_value(), o.alias_subelement.has_value());
+    if (o.alias_subelement)
+      CHECK_MEMBER(*v.alias_subelement(), *o.alias_subelement, name);
+    CHECK_EQ(v.implicitexternsyncparams().has_value(),
+             o.implicitexternsyncparams.has_value());
+    if (o.implicitexternsyncparams)
+      CHECK_MEMBER(*v.implicitexternsyncparams(), *o.implicitexternsyncparams,
+                   param);
+    CHECK_EQ(v.proto().has_value(), o.proto.has_value());
+    if (o.proto) {
+      CHECK_MEMBER(*v.proto(), *o.proto, name);
+      CHECK_MEMBER(*v.proto(), *o.proto, type);
+      CHECK(v.proto()->text() == o.proto->_text_);
+    }
+    check_each(v.param(), o.param, [](const auto& pv, const auto& po) {
+      CHECK_MEMBER(pv, po, altlen);
+      CHECK_MEMBER(pv, po, externsync);
+      CHECK_MEMBER(pv, po, len);
+      CHECK_MEMBER(pv, po, noautovalidity);
+      CHECK_MEMBER(pv, po, optional);
+      CHECK_MEMBER(pv, po, name);
+      CHECK_MEMBER(pv, po, type);
+      CHECK(pv.text() == po._text_);
+    });
+    check_parse(v, o);
+  });
+}
+
+void check(const vkr::Types_view& view, const vkr::Types& object) {
+  CHECK_MEMBER(view, object, comment_attribute);
+  CHECK_MEMBER(view, object, comment_subelement);
+  check_each(view.type(), object.type, [](const auto& v, const auto& o) {
+    CHECK_MEMBER(v, o, alias);
+    CHECK_MEMBER(v, o, api);
+    CHECK_MEMBER(v, o, category);
+    CHECK_MEMBER(v, o, comment_attribute);
+    CHECK_MEMBER(v, o, name_attribute);
+    CHECK_MEMBER(v, o, parent);
+    CHECK_MEMBER(v, o, requires);
+    CHECK_MEMBER(v, o, returnedonly);
+    CHECK_MEMBER(v, o, structextends);
+    CHECK_MEMBER(v, o, apientry);
+    CHECK_MEMBER(v, o, comment_subelement);
+    CHECK_MEMBER(v, o, name_subelement);
+    CHECK_MEMBER(v, o, type);
+    CHECK(v.text() == o._text_);
+    check_each(v.member(), o.member, [](const auto& mv, const auto& mo) {
+      CHECK_MEMBER(mv, mo, altlen);
+      CHECK_MEMBER(mv, mo, externsync);
+      CHECK_MEMBER(mv, mo, len);
+      CHECK_MEMBER(mv, mo, noautovalidity);
+      CHECK_MEMBER(mv, mo, optional);
+      CHECK_MEMBER(mv, mo, values);
+      CHECK_MEMBER(mv, mo, comment);
+      CHECK_MEMBER(mv, mo, enum_);
+      CHECK_MEMBER(mv, mo, name);
+      CHECK_MEMBER(mv, mo, type);
+      CHECK(mv.text() == mo._text_);
+    });
+    check_parse(v, o);
+  });
+}
+
+void check(const vkr::Enums_view& view, const vkr::Enums& object) {
+  CHECK_MEMBER(view, object, comment_attribute);
+  CHECK_MEMBER(view, object, end);
+  CHECK_MEMBER(view, object, name);
+  CHECK_MEMBER(view, object, start);
+  CHECK_MEMBER(view, object, type);
+  CHECK_MEMBER(view, object, vendor);
+  CHECK_MEMBER(view, object, comment_subelement);
+  check_each(view.enum_(), object.enum_, [](const auto& v, const auto& o) {
+    CHECK_MEMBER(v, o, alias);
+    CHECK_MEMBER(v, o, api);
+    CHECK_MEMBER(v, o, bitpos);
+    CHECK_MEMBER(v, o, comment);
+    CHECK_MEMBER(v, o, dir);
+    CHECK_MEMBER(v, o, extends);
+    CHECK_MEMBER(v, o, extnumber);
+    CHECK_MEMBER(v, o, name);
+    CHECK_MEMBER(v, o, offset);
+    CHECK_MEMBER(v, o, type);
+    CHECK_MEMBER(v, o, value);
+  });
+  check_each(view.unused(), object.unused, [](const auto& v, const auto& o) {
+    CHECK_MEMBER(v, o, comment);
+    CHECK_MEMBER(v, o, end);
+    CHECK_MEMBER(v, o, start);
+    CHECK_MEMBER(v, o, vendor);
+  });
+  check_parse(view, object);
+}
+
+// The interface elements of a <require> or <remove>.
+template<class View, class Class>
+void check_interface(const View& view, const Class& object) {
+  CHECK_MEMBER(view, object, comment_attribute);
+  CHECK_MEMBER(view, object, profile);
+  CHECK_MEMBER(view, object, comment_subelement);
+  check_each(view.command(), object.command, [](const auto& v, const auto& o) {
+    CHECK_MEMBER(v, o, comment);
+    CHECK_MEMBER(v, o, name);
+  });
+  check_each(view.type(), object.type, [](const auto& v, const auto& o) {
+    CHECK_MEMBER(v, o, comment);
+    CHECK_MEMBER(v, o, name);
+  });
+  check_each(view.enum_(), object.enum_, [](const auto& v, const auto& o) {
+    CHECK_MEMBER(v, o, name);
+    CHECK_MEMBER(v, o, value);
+    CHECK_MEMBER(v, o, extends);
+    CHECK_MEMBER(v, o, offset);
+  });
+  check_parse(view, object);
+}
+
+void check(const vkr::Extensions_view& view, const vkr::Extensions& object) {
+  CHECK_MEMBER(view, object, comment);
+  check_each(view.extension(), object.extension, [](const auto& v,
+                                                     const auto& o) {
+    CHECK_MEMBER(v, o, author);
+    CHECK_MEMBER(v, o, comment);
+    CHECK_MEMBER(v, o, contact);
+    CHECK_MEMBER(v, o, deprecatedby);
+    CHECK_MEMBER(v, o, name);
+    CHECK_MEMBER(v, o, number);
+    CHECK_MEMBER(v, o, obsoletedby);
+    CHECK_MEMBER(v, o, platform);
+    CHECK_MEMBER(v, o, promotedto);
+    CHECK_MEMBER(v, o, protect);
+    CHECK_MEMBER(v, o, provisional);
+    CHECK_MEMBER(v, o, requires);
+    CHECK_MEMBER(v, o, requiresCore);
+    CHECK_MEMBER(v, o, supported);
+    CHECK_MEMBER(v, o, type);
+    check_each(v.require(), o.require, [](const auto& rv, const auto& ro) {
+      CHECK_MEMBER(rv, ro, api);
+      CHECK_MEMBER(rv, ro, extension);
+      CHECK_MEMBER(rv, ro, feature);
+      check_interface(rv, ro);
+    });
+    check_each(v.remove(), o.remove, [](const auto& rv, const auto& ro) {
+      CHECK_MEMBER(rv, ro, api);
+      check_interface(rv, ro);
+    });
+  });
+}
+
+void check(const vkr::Feature_view& view, const vkr::Feature& object) {
+  CHECK_MEMBER(view, object, api);
+  CHECK_MEMBER(view, object, comment);
+  CHECK_MEMBER(view, object, name);
+  CHECK_MEMBER(view, object, number);
+  CHECK_MEMBER(view, object, protect);
+  check_each(view.require(), object.require, [](const auto& v, const auto& o) {
+    CHECK_MEMBER(v, o, extension);
+    check_interface(v, o);
+  });
+  check_each(view.remove(), object.remove, [](const auto& v, const auto& o) {
+    check_interface(v, o);
+  });
+}
+
+void check(const vkr::Platforms_view& view, const vkr::Platforms& object) {
+  CHECK_MEMBER(view, object, comment);
+  check_each(view.platform(), object.platform, [](const auto& v,
+                                                   const auto& o) {
+    CHECK_MEMBER(v, o, comment);
+    CHECK_MEMBER(v, o, name);
+    CHECK_MEMBER(v, o, protect);
+  });
+  check_parse(view, object);
+}
+
+void check(const vkr::Tags_view& view, const vkr::Tags& object) {
+  CHECK_MEMBER(view, object, comment);
+  check_each(view.tag(), object.tag, [](const auto& v, const auto& o) {
+    CHECK_MEMBER(v, o, author);
+    CHECK_MEMBER(v, o, contact);
+    CHECK_MEMBER(v, o, name);
+  });
+  check_parse(view, object);
+}
+
+void check(const vkr::start_view& view, const vkr::start& object) {
+  CHECK_MEMBER(view, object, comment);
+  auto recurse = [](const auto& v, const auto& o) { check(v, o); };
+  check_each(view.commands(), object.commands, recurse);
+  check_each(view.types(), object.types, recurse);
+  check_each(view.enums(), object.enums, recurse);
+  check_each(view.extensions(), object.extensions, recurse);
+  check_each(view.feature(), object.feature, recurse);
+  check_each(view.platforms(), object.platforms, recurse);
+  check_each(view.tags(), object.tags, recurse);
+  check_parse(view, object);
+}
+
+// Parses xml each way and checks that they agree.
+vkr::start check_document(const std::string& filename, std::string_view xml) {
+  tinyxml2::XMLDocument doc;
+  CHECK(doc.Parse(xml.data(), xml.size()) == tinyxml2::XML_SUCCESS)
+      << "Unable to parse " << filename;
+  auto dom = relaxng::parse<vkr::start>(doc.RootElement());
+
+  dvc::xml_reader r(filename, xml);
+  auto streamed = relaxng::parse_document<vkr::start>(r);
+  CHECK(relaxng::equal(streamed, dom)) << filename;
+
+  relaxng::ViewSource source{filename, xml};
+  check(relaxng::view_document<vkr::start_view>(source), dom);
+  return dom;
+}
+
+// Elements the schema does not know are skipped unparsed, by scanning for
+// their tags.  The skip must end at the right end tag past comments, CDATA,
+// processing instructions, quoted '>'s and empty element tags, all of which
+// may hold what looks like that end tag.  Within a class that captures
+// text the skip reads the element in full instead.
+constexpr std::string_view unknown_elements = R"(<?xml version="1.0"?>
+<registry>
+  <platforms comment="before">
+    <platform name="a" protect="A"/>
+    <unknown attr="x>y" other='">' empty="">
+      <!-- </unknown> <platform name="comment"/> --><!-- > <b> -->
+      <![CDATA[ </unknown> <platform name="cdata"/> ]]><![CDATA[ ] > <b> ]]>
+      <?pi </unknown> ?><?pi > <b> ?>
+      <b/><b x="/>"/><b y='</unknown>' />
+      <unknown><c>nested</c><d/></unknown>
+      text &amp; <e f=">"></e>
+    </unknown>
+    <platform name="b" protect="B"/>
+    <empty/>
+  </platforms>
+  <types>
+    <type category="struct" name="T">struct <unknown a=">"><!-- x --><b/>u</unknown><member>int <name>m</name></member></type>
+  </types>
+</registry>
+)";
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  for (std::string_view filename : dvc::split_view(",", FLAGS_vkxml)) {
+    std::string path(filename);
+    dvc::mapped_file vkxml = dvc::load_file(path, dvc::mapped);
+    check_document(path, vkxml);
+  }
+
+  vkr::start start = check_document("unknown_elements", unknown_elements);
+  CHECK_EQ(start.platforms.size(), 1u);
+  const vkr::Platforms& platforms = start.platforms[0];
+  CHECK(platforms.comment == std::string_view("before"));
+  CHECK_EQ(platforms.platform.size(), 2u);
+  CHECK(platforms.platform[0].name == std::string_view("a"));
+  CHECK(platforms.platform[1].name == std::string_view("b"));
+  CHECK_EQ(start.types.size(), 1u);
+  CHECK_EQ(start.types[0].type.size(), 1u);
+  CHECK_EQ(start.types[0].type[0].member.size(), 1u);
+}
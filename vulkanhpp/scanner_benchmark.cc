@@ -0,0 +1,129 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <x86intrin.h>
+#include <iostream>
+
+#include "core/file.h"
+#include "core/scanner.h"
+
+DEFINE_string(rnc, "", "Compact relaxng schema to lex");
+DEFINE_string(vkxml, "", "vk.xml to extract C declarations from");
+DEFINE_int32(iterations, 200, "Number of passes over each input");
+
+namespace {
+
+constexpr dvc::byte_class identifier_chars{
+    {'0', '9'}, {'A', 'Z'}, {'a', 'z'}, {'_', '_'}, {':', ':'}};
+constexpr dvc::byte_class newline{{'\n', '\n'}};
+
+// The byte-at-a-time loops the schema and C scanners used before the bulk
+// primitives.
+size_t lex_bytewise(dvc::scanner& s) {
+  size_t tokens = 0;
+  while (true) {
+    while (true) {
+      if (std::isspace(s.peek())) {
+        s.incr();
+        continue;
+      }
+      if (s.peek() == '#') {
+        do {
+          s.incr();
+        } while (s.peek() != '\n' && s.peek() != dvc::scanner::eof);
+        continue;
+      }
+      break;
+    }
+    char c = s.peek();
+    if (c == dvc::scanner::eof) return tokens;
+    if (std::isalnum(c) || c == '_' || c == ':') {
+      while (std::isalnum(s.peek()) || s.peek() == '_' || s.peek() == ':')
+        s.incr();
+    } else {
+      s.incr();
+    }
+    tokens++;
+  }
+}
+
+size_t lex_bulk(dvc::scanner& s) {
+  size_t tokens = 0;
+  while (true) {
+    while (true) {
+      s.skip_while(dvc::whitespace);
+      if (s.peek() == '#') {
+        s.skip_until(newline);
+        continue;
+      }
+      break;
+    }
+    char c = s.peek();
+    if (c == dvc::scanner::eof) return tokens;
+    if (identifier_chars.contains(c))
+      s.skip_while(identifier_chars);
+    else
+      s.incr();
+    tokens++;
+  }
+}
+
+// The text of every <member>, <param> and <proto>, with markup stripped, as
+// handed to the minic parser.
+std::string extract_c_declarations(std::string_view xml) {
+  std::string out;
+  for (std::string_view tag : {"member", "param", "proto"}) {
+    std::string open = "<" + std::string(tag);
+    std::string close = "</" + std::string(tag) + ">";
+    for (size_t pos = xml.find(open); pos != std::string_view::npos;
+         pos = xml.find(open, pos)) {
+      size_t begin = xml.find('>', pos) + 1;
+      size_t end = xml.find(close, begin);
+      if (end == std::string_view::npos) break;
+      bool in_tag = false;
+      for (char c : xml.substr(begin, end - begin)) {
+        if (c == '<') in_tag = true;
+        if (!in_tag) out += c;
+        if (c == '>') in_tag = false;
+      }
+      out += '\n';
+      pos = end;
+    }
+  }
+  return out;
+}
+
+template <typename Lexer>
+void run(const std::string& name, std::string_view input, Lexer lex) {
+  size_t tokens = 0;
+  uint64_t start = __rdtsc();
+  for (int i = 0; i < FLAGS_iterations; i++) {
+    dvc::scanner s(name, input, dvc::borrow);
+    tokens += lex(s);
+  }
+  uint64_t cycles = __rdtsc() - start;
+  double bytes = double(input.size()) * FLAGS_iterations;
+  std::cout << name << ": " << tokens / FLAGS_iterations << " tokens, "
+            << bytes / cycles << " bytes/cycle" << std::endl;
+}
+
+void benchmark(const std::string& name, std::string_view input) {
+  run(name + " bytewise", input, lex_bytewise);
+  run(name + " bulk", input, lex_bulk);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(!FLAGS_rnc.empty()) << "--rnc required";
+  CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
+
+  std::string rnc = dvc::load_file(FLAGS_rnc);
+  std::string c_declarations =
+      extract_c_declarations(dvc::load_file(FLAGS_vkxml));
+
+  benchmark("registry.rnc", rnc);
+  benchmark("vk.xml declarations", c_declarations);
+}
@@ -5,7 +5,7 @@
 namespace sps {
 
 struct Entity {
-  std::string name;
+  dvc::interned_string name;
 };
 
 struct Enumerator : Entity {
@@ -15,13 +15,13 @@ struct Enumerator : Entity {
 struct Enumeration : Entity {
   const vks::Enumeration* enumeration;
   std::vector<Enumerator> enumerators;
-  std::vector<std::string> aliases;
+  std::vector<dvc::interned_string> aliases;
 };
 
 struct Bitmask : Entity {
   const vks::Bitmask* bitmask;
   std::vector<Enumerator> enumerators;
-  std::vector<std::string> aliases;
+  std::vector<dvc::interned_string> aliases;
 };
 
 struct Constant : Entity {
@@ -29,6 +29,9 @@ struct Constant : Entity {
 };
 
 struct Registry {
+  // Owns every entity of the registry.
+  dvc::arena arena;
+
   std::vector<Enumeration*> enumerations;
   std::vector<Bitmask*> bitmasks;
   std::vector<Constant*> constants;
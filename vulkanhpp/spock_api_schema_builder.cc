@@ -4,6 +4,7 @@
 #include <cctype>
 #include <clocale>
 #include <set>
+#include <unordered_set>
 
 #include "core/container.h"
 
@@ -108,28 +109,27 @@ void build_enum(sps::Registry& sreg, const vks::Registry& vreg) {
 
   auto convert_enumeration = [&](std::string name,
                                  const vks::Enumeration* venumeration) {
-    auto senumeration = new sps::Enumeration;
+    auto senumeration = sreg.arena.make<sps::Enumeration>();
     senumeration->name = translate_enumeration_name(name);
     senumeration->enumeration = venumeration;
+    std::vector<std::string> unstripped_names;
+    unstripped_names.push_back(senumeration->name.str() + "_");
     for (const auto& venumerator : venumeration->enumerators) {
-      sps::Enumerator senumerator;
-      senumerator.name = translate_enumerator_name(venumerator->name);
-      senumerator.constant = venumerator;
+      unstripped_names.push_back(translate_enumerator_name(venumerator->name));
       constants_done.insert(venumerator);
-
-      senumeration->enumerators.push_back(senumerator);
     }
-    std::vector<std::string> unstripped_names;
-    unstripped_names.push_back(senumeration->name + "_");
-    for (const auto& senumerator : senumeration->enumerators)
-      unstripped_names.push_back(senumerator.name);
     size_t strip = common_prefix(unstripped_names).size();
     while (strip != 0) {
       if (unstripped_names.at(0).at(strip - 1) == '_') break;
       strip--;
     }
-    for (auto& senumerator : senumeration->enumerators)
-      senumerator.name = final_enum_fix(senumerator.name.substr(strip));
+    for (size_t i = 0; i < venumeration->enumerators.size(); i++) {
+      sps::Enumerator senumerator;
+      senumerator.name =
+          final_enum_fix(unstripped_names.at(i + 1).substr(strip));
+      senumerator.constant = venumeration->enumerators[i];
+      senumeration->enumerators.push_back(senumerator);
+    }
     for (const auto& [aname, alias] : vreg.enumerations) {
       if (venumeration == alias && aname != alias->name) {
         senumeration->aliases.push_back(translate_enumeration_name(aname));
@@ -143,7 +143,7 @@ void build_enum(sps::Registry& sreg, const vks::Registry& vreg) {
 
   for (const auto& [name, vbitmask] : vreg.bitmasks) {
     if (name != vbitmask->name) continue;
-    sps::Bitmask* bitmask = new sps::Bitmask;
+    sps::Bitmask* bitmask = sreg.arena.make<sps::Bitmask>();
     bitmask->name = translate_bitmask_name(name);
     bitmask->bitmask = vbitmask;
     if (vbitmask->requires) {
@@ -151,10 +151,11 @@ void build_enum(sps::Registry& sreg, const vks::Registry& vreg) {
       sps::Enumeration* enumeration =
           convert_enumeration(name, vbitmask->requires);
       for (sps::Enumerator enumerator : enumeration->enumerators) {
-        size_t bitpos = enumerator.name.rfind("_bit");
+        const std::string& unfixed = enumerator.name;
+        size_t bitpos = unfixed.rfind("_bit");
         if (bitpos != std::string::npos)
-          enumerator.name = final_enum_fix(enumerator.name.substr(0, bitpos) +
-                                           enumerator.name.substr(bitpos + 4));
+          enumerator.name = final_enum_fix(unfixed.substr(0, bitpos) +
+                                           unfixed.substr(bitpos + 4));
         bitmask->enumerators.push_back(enumerator);
       }
     }
@@ -181,7 +182,7 @@ void build_enum(sps::Registry& sreg, const vks::Registry& vreg) {
   for (const auto& [name, vconstant] : vreg.constants) {
     if (constants_done.count(vconstant)) continue;
     if (name == "VK_TRUE" || name == "VK_FALSE") continue;
-    sps::Constant* sconstant = new sps::Constant;
+    sps::Constant* sconstant = sreg.arena.make<sps::Constant>();
     sconstant->name = translate_enumerator_name(name);
     sconstant->constant = vconstant;
     sreg.constants.push_back(sconstant);
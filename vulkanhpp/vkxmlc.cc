@@ -1,12 +1,15 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
+#include <functional>
 #include <iostream>
+#include <optional>
 #include <set>
 #include <unordered_set>
 
 #include "core/container.h"
 #include "core/file.h"
 #include "core/string.h"
+#include "core/xml.h"
 
 #include "vulkanhpp/spock_api_schema.h"
 #include "vulkanhpp/spock_api_schema_builder.h"
@@ -18,9 +21,30 @@ DEFINE_string(vkxml, "", "Input vk.xml file");
 DEFINE_string(outjson, "", "Output AST to json");
 DEFINE_string(outtest, "", "Output test of API");
 DEFINE_string(outh, "", "Output C++ header");
+DEFINE_string(snapshot, "",
+              "Cache of the parsed vk.xml, reused while vk.xml and the "
+              "schema are unchanged");
+
+// Parses vk.xml, or reloads it from --snapshot if that was written from the
+// same vk.xml by a build with the same schema.
+vkr::start load_vkxml() {
+  dvc::mapped_file vkxml = dvc::load_file(FLAGS_vkxml, dvc::mapped);
+  if (!FLAGS_snapshot.empty() && exists(dvc::fspath(FLAGS_snapshot))) {
+    std::optional<vkr::start> start = relaxng::read_binary<vkr::start>(
+        dvc::load_file(FLAGS_snapshot, dvc::mapped), vkxml);
+    if (start) return std::move(*start);
+  }
+  dvc::xml_reader reader(FLAGS_vkxml, vkxml);
+  vkr::start start = relaxng::parse_document<vkr::start>(reader);
+  if (!FLAGS_snapshot.empty()) {
+    dvc::file_writer w(FLAGS_snapshot, dvc::replace);
+    w.write(relaxng::write_binary(start, vkxml));
+  }
+  return start;
+}
 
 void write_test(const vks::Registry& registry) {
-  dvc::file_writer test(FLAGS_outtest, dvc::truncate);
+  dvc::file_writer test(FLAGS_outtest, dvc::if_changed);
 
   test.println("#include \"vulkanhpp/vkxmltest.h\"");
 
@@ -86,7 +110,7 @@ void write_test(const vks::Registry& registry) {
 }
 
 void write_header(const sps::Registry& registry) {
-  dvc::file_writer h(FLAGS_outh, dvc::truncate);
+  dvc::file_writer h(FLAGS_outh, dvc::if_changed);
 
   h.println("#pragma once");
   h.println();
@@ -156,15 +180,11 @@ int main(int argc, char** argv) {
 
   CHECK(!FLAGS_vkxml.empty()) << "--vkxml required";
 
-  tinyxml2::XMLDocument doc;
-  CHECK(doc.LoadFile(FLAGS_vkxml.c_str()) == tinyxml2::XML_SUCCESS)
-      << "Unable to parse " << FLAGS_vkxml;
-
-  auto start = relaxng::parse<vkr::start>(doc.RootElement());
+  vkr::start start = load_vkxml();
 
   if (!FLAGS_outjson.empty()) {
-    dvc::file_writer fw(FLAGS_outjson, dvc::truncate);
-    dvc::json_writer jw(fw.ostream());
+    dvc::file_writer fw(FLAGS_outjson, dvc::if_changed);
+    dvc::json_writer jw(fw);
     write_json(jw, start);
   }
 
@@ -1,78 +1,83 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
 #include <vector>
-#include <unordered_set>
 #include <sstream>
 
+#include "core/arena.h"
+#include "core/container.h"
+#include "core/intern.h"
+
 namespace vks {
 
 struct Entity {
-  std::string name;
+  dvc::interned_string name;
 
   virtual ~Entity() = default;
 };
 
+// Types and expressions are hash-consed by Registry: structurally identical
+// ones are the same node, so they compare by pointer, and each node's
+// spelling is computed once when it is created.
 struct Type {
-  virtual std::string to_string() const = 0;
+  const std::string& to_string() const { return spelling; }
   virtual ~Type() = default;
+
+ protected:
+  std::string spelling;
 };
 
 struct Expr {
-  virtual std::string to_string() const = 0;
+  const std::string& to_string() const { return spelling; }
   virtual ~Expr() = default;
+
+ protected:
+  std::string spelling;
 };
 
 struct Reference : Expr {
+  explicit Reference(Entity* entity) : entity(entity) {
+    spelling = entity->name;
+  }
   Entity* entity;
-  std::string to_string() const override {
-    return entity->name;
-  };
 };
 
-struct Number : Expr { std::string number;
-  std::string to_string() const override {
-    return number;
-  };
+struct Number : Expr {
+  explicit Number(dvc::interned_string number) : number(number) {
+    spelling = number;
+  }
+  dvc::interned_string number;
 };
 
-struct Name : Type{
+struct Name : Type {
+  explicit Name(Entity* entity) : entity(entity) { spelling = entity->name; }
   Entity* entity;
-  std::string to_string() const override {
-    return entity->name;
-  };
 };
 
 struct Const : Type {
+  explicit Const(Type* T) : T(T) { spelling = T->to_string() + " const"; }
   Type* T;
-  std::string to_string() const override {
-    return T->to_string() + " " + "const";
-  };
 };
 
 struct Pointer : Type {
+  explicit Pointer(Type* T) : T(T) { spelling = T->to_string() + " *"; }
   Type* T;
-  std::string to_string() const override {
-    return T->to_string() + " " + "*";
-  };
 };
 
 struct Array : Type {
+  Array(Type* T, Expr* N) : T(T), N(N) {
+    spelling = T->to_string() + " [" + N->to_string() + "]";
+  }
   Type* T;
   Expr* N;
-
-  std::string to_string() const override {
-    return T->to_string() + " [" + N->to_string() + "]";
-  };
 };
 
 struct External : Entity {
 };
 
 struct Platform {
-  std::string name;
-  std::string protect;
+  dvc::interned_string name;
+  dvc::interned_string protect;
 };
 
 struct Constant : Entity {
@@ -95,7 +100,7 @@ struct Handle : Entity {
 };
 
 struct Member {
-  std::string name;
+  dvc::interned_string name;
   Type* type;
 };
 
@@ -108,7 +113,7 @@ struct Struct : Entity {
 };
 
 struct FunctionPrototypeParam {
-  std::string name;
+  dvc::interned_string name;
   Type* type;
 };
 
@@ -129,12 +134,11 @@ struct FunctionPrototype : Entity {
 };
 
 struct CommandParam {
-  std::string name;
+  dvc::interned_string name;
   Type* type = nullptr;
 };
 
 struct Command : Entity {
-  std::string name;
   Type* return_type = nullptr;
   std::vector<CommandParam> params;
   const Platform* platform = nullptr;
@@ -160,36 +164,70 @@ struct Extension {
 };
 
 struct Registry {
-  std::unordered_map<std::string, Entity*> entities;
-
-  std::unordered_map<std::string, Platform*> platforms;
-  std::unordered_map<std::string, Constant*> constants;
-  std::unordered_map<std::string, Enumeration*> enumerations;
-  std::unordered_map<std::string, Bitmask*> bitmasks;
-  std::unordered_map<std::string, Handle*> handles;
-  std::unordered_map<std::string, Struct*> structs;
-  std::unordered_map<std::string, FunctionPrototype*> function_prototypes;
-  std::unordered_map<std::string, Command*> commands;
-  std::unordered_map<std::string, External*> externals;
-
-  ~Registry() {
-    delete_map(platforms);
-    delete_map(constants);
-    delete_map(enumerations);
-    delete_map(bitmasks);
-    delete_map(handles);
-    delete_map(commands);
+  // Owns every entity, platform, type and expression of the registry.
+  dvc::arena arena;
+
+  dvc::dense_hash_map<dvc::interned_string, Entity*> entities;
+
+  dvc::dense_hash_map<dvc::interned_string, Platform*> platforms;
+  dvc::dense_hash_map<dvc::interned_string, Constant*> constants;
+  dvc::dense_hash_map<dvc::interned_string, Enumeration*> enumerations;
+  dvc::dense_hash_map<dvc::interned_string, Bitmask*> bitmasks;
+  dvc::dense_hash_map<dvc::interned_string, Handle*> handles;
+  dvc::dense_hash_map<dvc::interned_string, Struct*> structs;
+  dvc::dense_hash_map<dvc::interned_string, FunctionPrototype*> function_prototypes;
+  dvc::dense_hash_map<dvc::interned_string, Command*> commands;
+  dvc::dense_hash_map<dvc::interned_string, External*> externals;
+
+  // The unique type or expression node of each shape.
+  Name* name_type(Entity* entity) {
+    return unique<Name>({NAME, entity, nullptr}, entity);
+  }
+  Const* const_type(Type* T) { return unique<Const>({CONST, T, nullptr}, T); }
+  Pointer* pointer_type(Type* T) {
+    return unique<Pointer>({POINTER, T, nullptr}, T);
+  }
+  Array* array_type(Type* T, Expr* N) {
+    return unique<Array>({ARRAY, T, N}, T, N);
+  }
+  Reference* reference_expr(Entity* entity) {
+    return unique<Reference>({REFERENCE, entity, nullptr}, entity);
+  }
+  Number* number_expr(dvc::interned_string number) {
+    return unique<Number>({NUMBER, number.c_str(), nullptr}, number);
   }
 
  private:
-  template<typename Map>
-  static void delete_map(Map& m) {
-    std::unordered_set<typename Map::mapped_type> s;
-    for (auto& kv : m)
-      s.insert(kv.second);
-    for (auto& v : s)
-      delete v;
+  enum NodeKind { NAME, CONST, POINTER, ARRAY, REFERENCE, NUMBER };
+
+  // A node is identified by its kind and the (unique) nodes, entities or
+  // interned strings it is built from.
+  struct NodeKey {
+    NodeKind kind;
+    const void* a;
+    const void* b;
+
+    bool operator==(const NodeKey& that) const {
+      return kind == that.kind && a == that.a && b == that.b;
+    }
+  };
+
+  struct NodeKeyHash {
+    size_t operator()(const NodeKey& k) const {
+      size_t h = std::hash<const void*>()(k.a);
+      h = h * 31 + std::hash<const void*>()(k.b);
+      return h * 31 + k.kind;
+    }
+  };
+
+  template<typename T, typename... Args>
+  T* unique(const NodeKey& key, Args... args) {
+    auto [it, inserted] = nodes.try_emplace(key, nullptr);
+    if (inserted) it->second = arena.make<T>(args...);
+    return static_cast<T*>(it->second);
   }
+
+  dvc::dense_hash_map<NodeKey, void*, NodeKeyHash> nodes;
 };
 
 }  // namespace vks
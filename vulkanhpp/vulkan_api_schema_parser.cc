@@ -1,7 +1,6 @@
 #include "vulkan_api_schema_parser.h"
 
 #include <map>
-#include <set>
 
 #include "core/container.h"
 #include "core/string.h"
@@ -12,43 +11,50 @@ namespace {
 void parse_platforms(vks::Registry& registry, const vkr::start& start) {
   for (const auto& platforms : start.platforms)
     for (const vkr::Platform& platform_in : platforms.platform) {
-      auto platform_out = new vks::Platform;
+      auto platform_out = registry.arena.make<vks::Platform>();
       platform_out->name = platform_in.name;
       platform_out->protect = platform_in.protect;
       dvc::insert_or_die(registry.platforms, platform_out->name, platform_out);
     }
 }
 
-std::string enum_to_value(const vkr::Enum& enum_,
-                          std::optional<std::string> extnumber = std::nullopt) {
-  if (enum_.value)
-    return "(" + enum_.value.value() + ")";
-  else if (enum_.bitpos)
-    return "(1 << (" + enum_.bitpos.value() + "))";
-  else if (enum_.alias)
-    return "(" + enum_.alias.value() + ")";
-  else if (enum_.offset) {
-    if (enum_.extnumber) extnumber = enum_.extnumber;
+std::string enum_to_value(const relaxng::Table<vkr::Enum>& enums, size_t i,
+                          std::optional<int64_t> extnumber = std::nullopt) {
+  if (auto value = enums.get<&vkr::Enum::value>(i))
+    return "(" + value->str() + ")";
+  else if (auto bitpos = enums.get<&vkr::Enum::bitpos>(i))
+    return "(1 << (" + std::to_string(*bitpos) + "))";
+  else if (auto alias = enums.get<&vkr::Enum::alias>(i))
+    return "(" + alias->str() + ")";
+  else if (auto offset = enums.get<&vkr::Enum::offset>(i)) {
+    if (enums.has<&vkr::Enum::extnumber>(i))
+      extnumber = enums.get<&vkr::Enum::extnumber>(i);
     CHECK(extnumber);
-    bool neg = enum_.dir.has_value();
-    if (neg) CHECK(enum_.dir.value() == "-");
+    auto dir = enums.get<&vkr::Enum::dir>(i);
+    bool neg = dir.has_value();
+    if (neg) CHECK(dir.value() == "-");
     return std::string("(") + (neg ? "-1" : "+1") + "* (1'000'000'000 + (" +
-           extnumber.value() + "-1) * 1'000 + " + enum_.offset.value() + "))";
+           std::to_string(extnumber.value()) + "-1) * 1'000 + " +
+           std::to_string(*offset) + "))";
   } else {
-    LOG(FATAL) << "bad enum " << enum_.name;
+    LOG(FATAL) << "bad enum " << enums.get<&vkr::Enum::name>(i);
   }
 }
 
+bool is_extension_enum(const relaxng::Table<vkr::Enum>& enums, size_t i) {
+  return enums.has<&vkr::Enum::value>(i) || enums.has<&vkr::Enum::bitpos>(i) ||
+         enums.has<&vkr::Enum::alias>(i) || enums.has<&vkr::Enum::offset>(i);
+}
+
 template <typename F>
 void foreach_extension(const vks::Registry& registry, const vkr::start& start,
                        F process_require) {
   for (const vkr::Extensions& extensions : start.extensions) {
     for (const vkr::Extension& extension : extensions.extension) {
-      std::string supported = extension.supported.value();
-      CHECK(supported == "disabled" || supported == "vulkan") << supported;
-      if (supported == "disabled") continue;
+      if (extension.supported.value() == vkr::ExtensionSupport::disabled)
+        continue;
 
-      std::optional<std::string> extnumber = extension.number;
+      std::optional<int64_t> extnumber = extension.number;
 
       const vks::Platform* platform = nullptr;
       if (extension.platform)
@@ -64,12 +70,13 @@ void foreach_extension(const vks::Registry& registry, const vkr::start& start,
 void parse_externals(vks::Registry& registry, const vkr::start& start) {
   for (const vkr::Types& stypes : start.types)
     for (const vkr::Type& type : stypes.type) {
-      if (!type.category.has_value() || type.category == "basetype" ||
-          type.category == "define") {
-        std::string name = type.name_attribute.has_value()
-                               ? type.name_attribute.value()
-                               : type.name_subelement.value();
-        auto external = new vks::External;
+      if (!type.category.has_value() ||
+          type.category == vkr::TypeCategory::basetype ||
+          type.category == vkr::TypeCategory::define) {
+        dvc::interned_string name = type.name_attribute.has_value()
+                                        ? type.name_attribute.value()
+                                        : type.name_subelement.value();
+        auto external = registry.arena.make<vks::External>();
         external->name = name;
         dvc::insert_or_die(registry.externals, name, external);
       }
@@ -77,60 +84,59 @@ void parse_externals(vks::Registry& registry, const vkr::start& start) {
 }
 
 void parse_constants(vks::Registry& registry,
-                     std::multimap<std::string, vks::Constant*>& extends,
+                     std::multimap<dvc::interned_string, vks::Constant*>& extends,
                      const vkr::start& start) {
   for (const vkr::Enums& enums : start.enums)
-    for (const vkr::Enum& enum_ : enums.enum_) {
-      auto constant = new vks::Constant;
-      constant->name = enum_.name;
-      constant->value = enum_to_value(enum_);
-      dvc::insert_or_die(registry.constants, enum_.name, constant);
-      if (enum_.extends)
-        extends.insert(std::make_pair(enum_.extends.value(), constant));
+    for (size_t i = 0; i < enums.enum_.size(); i++) {
+      auto constant = registry.arena.make<vks::Constant>();
+      constant->name = enums.enum_.get<&vkr::Enum::name>(i);
+      constant->value = enum_to_value(enums.enum_, i);
+      dvc::insert_or_die(registry.constants, constant->name, constant);
+      if (auto extends_name = enums.enum_.get<&vkr::Enum::extends>(i))
+        extends.insert(std::make_pair(extends_name.value(), constant));
     }
 
   for (const vkr::Feature& feature : start.feature) {
     CHECK(feature.remove.empty());
     for (const auto& require : feature.require) {
-      for (const vkr::Enum& enum_ : require.enum_) {
-        bool extension_enum =
-            enum_.value || enum_.bitpos || enum_.alias || enum_.offset;
-        if (!extension_enum)
-          CHECK(registry.constants.count(enum_.name) == 1) << enum_.name;
+      for (size_t i = 0; i < require.enum_.size(); i++) {
+        dvc::interned_string name = require.enum_.get<&vkr::Enum::name>(i);
+        if (!is_extension_enum(require.enum_, i))
+          CHECK(registry.constants.count(name) == 1) << name;
         else {
-          auto constant = new vks::Constant;
-          constant->name = enum_.name;
-          constant->value = enum_to_value(enum_);
-          dvc::insert_or_die(registry.constants, enum_.name, constant);
-          if (enum_.extends)
-            extends.insert(std::make_pair(enum_.extends.value(), constant));
+          auto constant = registry.arena.make<vks::Constant>();
+          constant->name = name;
+          constant->value = enum_to_value(require.enum_, i);
+          dvc::insert_or_die(registry.constants, name, constant);
+          if (auto extends_name = require.enum_.get<&vkr::Enum::extends>(i))
+            extends.insert(std::make_pair(extends_name.value(), constant));
         }
       }
     }
   }
 
   foreach_extension(
-      registry, start, [&](auto require, auto extnumber, auto platform) {
-        for (const vkr::Enum& enum_ : require.enum_) {
-          bool extension_enum =
-              enum_.value || enum_.bitpos || enum_.alias || enum_.offset;
-          if (!extension_enum)
-            CHECK(registry.constants.count(enum_.name) == 1) << enum_.name;
+      registry, start,
+      [&](const vkr::Extension_require& require, auto extnumber,
+          auto platform) {
+        for (size_t i = 0; i < require.enum_.size(); i++) {
+          dvc::interned_string name = require.enum_.get<&vkr::Enum::name>(i);
+          if (!is_extension_enum(require.enum_, i))
+            CHECK(registry.constants.count(name) == 1) << name;
           else {
-            std::string name = enum_.name;
-            std::string value = enum_to_value(enum_, extnumber);
+            std::string value = enum_to_value(require.enum_, i, extnumber);
             if (registry.constants.count(name))
               CHECK_EQ(value, registry.constants.at(name)->value)
                   << "mismatched value of " << name;
             else {
-              auto constant = new vks::Constant;
-              constant->name = enum_.name;
+              auto constant = registry.arena.make<vks::Constant>();
+              constant->name = name;
               constant->value = value;
               constant->platform = platform;
 
-              dvc::insert_or_die(registry.constants, enum_.name, constant);
-              if (enum_.extends)
-                extends.insert(std::make_pair(enum_.extends.value(), constant));
+              dvc::insert_or_die(registry.constants, name, constant);
+              if (auto extends_name = require.enum_.get<&vkr::Enum::extends>(i))
+                extends.insert(std::make_pair(extends_name.value(), constant));
             }
           }
         }
@@ -138,50 +144,50 @@ void parse_constants(vks::Registry& registry,
 }
 
 void parse_enumerations(vks::Registry& registry, const vkr::start& start) {
-  std::unordered_map<std::string, const vkr::Type*> types;
+  dvc::dense_hash_map<dvc::interned_string, const vkr::Type*> types;
 
   for (const vkr::Types& stypes : start.types)
     for (const vkr::Type& type : stypes.type) {
       if (type.alias) continue;
-      std::string name = type.name_attribute.has_value()
-                             ? type.name_attribute.value()
-                             : type.name_subelement.value();
+      dvc::interned_string name = type.name_attribute.has_value()
+                                      ? type.name_attribute.value()
+                                      : type.name_subelement.value();
       dvc::insert_or_die(types, name, &type);
     }
 
   for (const vkr::Types& stypes : start.types)
     for (const vkr::Type& type : stypes.type) {
       if (!type.alias) continue;
-      std::string name = type.name_attribute.has_value()
-                             ? type.name_attribute.value()
-                             : type.name_subelement.value();
+      dvc::interned_string name = type.name_attribute.has_value()
+                                      ? type.name_attribute.value()
+                                      : type.name_subelement.value();
       dvc::insert_or_die(types, name, types.at(type.alias.value()));
     }
 
   for (const vkr::Enums& enums : start.enums) {
     CHECK(enums.name);
-    std::string name = enums.name.value();
+    dvc::interned_string name = enums.name.value();
     if (name == "API Constants") continue;
     CHECK(types.count(name));
     CHECK(enums.type) << enums.name.value();
     const vkr::Type& type = (*types.at(name));
-    CHECK_EQ(type.category.value(), "enum");
-    auto enumeration = new vks::Enumeration;
+    CHECK_EQ(type.category.value(), vkr::TypeCategory::enum_);
+    auto enumeration = registry.arena.make<vks::Enumeration>();
     enumeration->name = name;
     CHECK_NE(name, "VkPeerMemoryFeatureFlagBitsKHR");
     dvc::insert_or_die(registry.enumerations, name, enumeration);
-    for (const vkr::Enum& enum_ : enums.enum_) {
-      registry.enumerations.at(name)->enumerators.push_back(
-          registry.constants.at(enum_.name));
+    for (size_t i = 0; i < enums.enum_.size(); i++) {
+      enumeration->enumerators.push_back(
+          registry.constants.at(enums.enum_.get<&vkr::Enum::name>(i)));
     }
   }
 
   for (const vkr::Types& stypes : start.types)
     for (const vkr::Type& type : stypes.type) {
-      std::string name = type.name_attribute.has_value()
-                             ? type.name_attribute.value()
-                             : type.name_subelement.value();
-      if (type.category != "enum") continue;
+      dvc::interned_string name = type.name_attribute.has_value()
+                                      ? type.name_attribute.value()
+                                      : type.name_subelement.value();
+      if (type.category != vkr::TypeCategory::enum_) continue;
       if (!type.alias) continue;
       dvc::insert_or_die(registry.enumerations, name,
                          registry.enumerations.at(type.alias.value()));
@@ -191,12 +197,12 @@ void parse_enumerations(vks::Registry& registry, const vkr::start& start) {
 void parse_bitmasks(vks::Registry& registry, const vkr::start& start) {
   for (const vkr::Types& stypes : start.types)
     for (const vkr::Type& type : stypes.type) {
-      std::string name = type.name_attribute.has_value()
-                             ? type.name_attribute.value()
-                             : type.name_subelement.value();
-      if (type.category != "bitmask") continue;
+      dvc::interned_string name = type.name_attribute.has_value()
+                                      ? type.name_attribute.value()
+                                      : type.name_subelement.value();
+      if (type.category != vkr::TypeCategory::bitmask) continue;
       if (type.alias) continue;
-      auto bitmask = new vks::Bitmask;
+      auto bitmask = registry.arena.make<vks::Bitmask>();
       bitmask->name = name;
       bitmask->requires =
           (type.requires ? registry.enumerations.at(type.requires.value())
@@ -207,10 +213,10 @@ void parse_bitmasks(vks::Registry& registry, const vkr::start& start) {
 
   for (const vkr::Types& stypes : start.types)
     for (const vkr::Type& type : stypes.type) {
-      std::string name = type.name_attribute.has_value()
-                             ? type.name_attribute.value()
-                             : type.name_subelement.value();
-      if (type.category != "bitmask") continue;
+      dvc::interned_string name = type.name_attribute.has_value()
+                                      ? type.name_attribute.value()
+                                      : type.name_subelement.value();
+      if (type.category != vkr::TypeCategory::bitmask) continue;
       if (!type.alias) continue;
       CHECK(registry.bitmasks.count(type.alias.value()));
       dvc::insert_or_die(registry.bitmasks, name,
@@ -218,7 +224,7 @@ void parse_bitmasks(vks::Registry& registry, const vkr::start& start) {
     }
 
   foreach_extension(registry, start,
-                    [&](auto require, auto extnumber, auto platform) {
+                    [&](const auto& require, auto extnumber, auto platform) {
                       for (const auto& type : require.type) {
                         if (registry.bitmasks.count(type.name)) {
                           registry.bitmasks.at(type.name)->platform = platform;
@@ -231,63 +237,45 @@ void parse_handles(vks::Registry& registry, const vkr::start& start) {
   auto foreach_handle = [&](auto process_handle) {
     for (const auto& types : start.types)
       for (const vkr::Type& type : types.type) {
-        if (type.category != "handle") continue;
-        std::string name = type.name_attribute.has_value()
-                               ? type.name_attribute.value()
-                               : type.name_subelement.value();
+        if (type.category != vkr::TypeCategory::handle) continue;
+        dvc::interned_string name = type.name_attribute.has_value()
+                                        ? type.name_attribute.value()
+                                        : type.name_subelement.value();
         process_handle(type, name);
       }
   };
 
-  foreach_handle([&](const vkr::Type& type, const std::string& name) {
+  foreach_handle([&](const vkr::Type& type, dvc::interned_string name) {
     if (type.alias) return;
-    std::string handle_type = type.type.at(0);
+    dvc::interned_string handle_type = type.type.at(0);
     CHECK(handle_type == "VK_DEFINE_HANDLE" ||
           handle_type == "VK_DEFINE_NON_DISPATCHABLE_HANDLE");
-    auto handle = new vks::Handle;
+    auto handle = registry.arena.make<vks::Handle>();
     handle->name = name;
     handle->dispatchable = (handle_type == "VK_DEFINE_HANDLE");
     dvc::insert_or_die(registry.handles, name, handle);
   });
 
-  foreach_handle([&](const vkr::Type& type, const std::string& name) {
+  foreach_handle([&](const vkr::Type& type, dvc::interned_string name) {
     if (!type.alias) return;
     dvc::insert_or_die(registry.handles, name,
                        registry.handles.at(type.alias.value()));
   });
 
-  foreach_handle([&](const vkr::Type& type, const std::string& name) {
+  foreach_handle([&](const vkr::Type& type, dvc::interned_string name) {
     if (type.alias) return;
     if (!type.parent) return;
     vks::Handle* handle = registry.handles.at(name);
-    for (const std::string& parent : dvc::split(",", type.parent.value())) {
+    for (std::string_view parent : dvc::split_view(",", type.parent.value())) {
       handle->parents.push_back(registry.handles.at(parent));
     }
   });
 }
 
-void parse_inner_text(std::ostream& o, relaxng::Element element,
-                      const std::set<std::string>& skipelements) {
-  for (auto p = element->FirstChild(); p != nullptr; p = p->NextSibling()) {
-    if (auto text = p->ToText()) {
-      std::string_view sv = text->Value();
-      o.write(sv.data(), sv.size());
-      o.write(" ", 1);
-    } else if (auto subelement = p->ToElement()) {
-      if (!skipelements.count(subelement->Name()))
-        parse_inner_text(o, subelement, skipelements);
-    }
-  }
-}
-
-std::string parse_inner_text(relaxng::Element element) {
-  std::set<std::string> skipelements = {"comment"};
-  std::ostringstream o;
-  parse_inner_text(o, element, skipelements);
-  return o.str();
-}
-
 struct TypeBackpatches {
+  // Owns the mnc type trees until they are translated.
+  dvc::arena arena;
+
   struct StructMemberBackpatch {
     size_t member_idx;
     mnc::Type* type;
@@ -331,52 +319,50 @@ void parse_structs(vks::Registry& registry, TypeBackpatches& backpatches,
   auto foreach_struct = [&](auto process_struct) {
     for (const auto& types : start.types)
       for (const vkr::Type& type : types.type) {
-        if (type.category != "struct" && type.category != "union") continue;
-        std::string name = type.name_attribute.has_value()
-                               ? type.name_attribute.value()
-                               : type.name_subelement.value();
+        if (type.category != vkr::TypeCategory::struct_ &&
+            type.category != vkr::TypeCategory::union_)
+          continue;
+        dvc::interned_string name = type.name_attribute.has_value()
+                                        ? type.name_attribute.value()
+                                        : type.name_subelement.value();
         process_struct(type, name);
       }
   };
 
-  foreach_struct([&](const vkr::Type& type, const std::string& name) {
+  foreach_struct([&](const vkr::Type& type, dvc::interned_string name) {
     if (type.alias) return;
-    bool is_union = (type.category == "union");
+    bool is_union = (type.category == vkr::TypeCategory::union_);
 
-    auto struct_ = new vks::Struct;
+    auto struct_ = registry.arena.make<vks::Struct>();
 
     struct_->name = name;
     struct_->is_union = is_union;
-    if (type.returnedonly) {
-      CHECK(type.returnedonly == "true");
-      struct_->returnedonly = true;
-    } else
-      struct_->returnedonly = false;
+    struct_->returnedonly = type.returnedonly.value_or(false);
     dvc::insert_or_die(registry.structs, name, struct_);
   });
 
-  foreach_struct([&](const vkr::Type& type, const std::string& name) {
+  foreach_struct([&](const vkr::Type& type, dvc::interned_string name) {
     if (!type.alias) return;
     dvc::insert_or_die(registry.structs, name,
                        registry.structs.at(type.alias.value()));
   });
 
-  foreach_struct([&](const vkr::Type& type, const std::string& name) {
+  foreach_struct([&](const vkr::Type& type, dvc::interned_string name) {
     if (type.structextends)
-      for (const std::string& structextends :
-           dvc::split(",", type.structextends.value()))
+      for (std::string_view structextends :
+           dvc::split_view(",", type.structextends.value()))
         registry.structs.at(name)->structextends.push_back(
             registry.structs.at(structextends));
   });
 
-  foreach_struct([&](const vkr::Type& type, const std::string& name) {
+  foreach_struct([&](const vkr::Type& type, dvc::interned_string name) {
     if (type.alias) return;
     vks::Struct* struct_ = registry.structs.at(name);
     for (const vkr::Type_member& member_in : type.member) {
       vks::Member member_out;
       member_out.name = member_in.name;
       mnc::Declaration decl =
-          mnc::parse_declaration(parse_inner_text(member_in._element_));
+          mnc::parse_declaration(member_in._text_, backpatches.arena);
       CHECK_EQ(member_in.name, decl.name);
       mnc::Type* member_type = decl.type;
       backpatches.add_struct_member_backpatch(struct_, struct_->members.size(),
@@ -386,7 +372,7 @@ void parse_structs(vks::Registry& registry, TypeBackpatches& backpatches,
   });
 
   foreach_extension(registry, start,
-                    [&](auto require, auto extnumber, auto platform) {
+                    [&](const auto& require, auto extnumber, auto platform) {
                       for (const auto& type : require.type) {
                         if (registry.structs.count(type.name)) {
                           registry.structs.at(type.name)->platform = platform;
@@ -400,21 +386,20 @@ void parse_funcpointers(vks::Registry& registry, TypeBackpatches& backpatches,
   auto foreach_funcpointer = [&](auto process_funcpointer) {
     for (const auto& types : start.types)
       for (const vkr::Type& type : types.type) {
-        if (type.category != "funcpointer") continue;
-        std::string name = type.name_attribute.has_value()
-                               ? type.name_attribute.value()
-                               : type.name_subelement.value();
+        if (type.category != vkr::TypeCategory::funcpointer) continue;
+        dvc::interned_string name = type.name_attribute.has_value()
+                                        ? type.name_attribute.value()
+                                        : type.name_subelement.value();
         process_funcpointer(type, name);
       }
   };
 
-  foreach_funcpointer([&](const vkr::Type& type, const std::string& name) {
+  foreach_funcpointer([&](const vkr::Type& type, dvc::interned_string name) {
     CHECK(!type.alias);
-    auto function_prototype_out = new vks::FunctionPrototype;
+    auto function_prototype_out = registry.arena.make<vks::FunctionPrototype>();
     function_prototype_out->name = name;
-    std::string decl = parse_inner_text(type._element_);
     mnc::FunctionPrototype function_prototype_in =
-        mnc::parse_function_prototype(decl);
+        mnc::parse_function_prototype(type._text_, backpatches.arena);
     CHECK_EQ(name, function_prototype_in.name);
 
     backpatches.add_function_prototype_backpatch(function_prototype_out,
@@ -435,17 +420,17 @@ void parse_commands(vks::Registry& registry, TypeBackpatches& backpatches,
   };
   foreach_command([&](const vkr::Command& command_in) {
     if (command_in.alias_attribute) return;
-    std::string name = command_in.proto.value().name;
-    auto command_out = new vks::Command;
+    dvc::interned_string name = command_in.proto.value().name;
+    auto command_out = registry.arena.make<vks::Command>();
     command_out->name = name;
     CHECK(command_in.proto.has_value());
     mnc::Declaration decl = mnc::parse_declaration(
-        parse_inner_text(command_in.proto.value()._element_));
+        command_in.proto.value()._text_, backpatches.arena);
     CHECK_EQ(decl.name, name);
     backpatches.add_command_return_backpatch(command_out, decl.type);
     for (const vkr::Command_param& param_in : command_in.param) {
       mnc::Declaration decl =
-          mnc::parse_declaration(parse_inner_text(param_in._element_));
+          mnc::parse_declaration(param_in._text_, backpatches.arena);
       CHECK_EQ(decl.name, param_in.name);
       vks::CommandParam param_out;
       param_out.name = decl.name;
@@ -457,31 +442,28 @@ void parse_commands(vks::Registry& registry, TypeBackpatches& backpatches,
   });
   foreach_command([&](const vkr::Command& command) {
     if (!command.alias_attribute) return;
-    std::string name = command.name.value();
-    std::string alias = command.alias_attribute.value();
+    dvc::interned_string name = command.name.value();
+    dvc::interned_string alias = command.alias_attribute.value();
     dvc::insert_or_die(registry.commands, name, registry.commands.at(alias));
   });
   foreach_extension(registry, start,
-                    [&](auto require, auto extnumber, auto platform) {
+                    [&](const auto& require, auto extnumber, auto platform) {
                       for (const auto& command : require.command)
                         registry.commands.at(command.name)->platform = platform;
                     });
 }
 
-vks::Entity* lookup_entity(vks::Registry& registry, const std::string& name) {
+vks::Entity* lookup_entity(vks::Registry& registry,
+                           dvc::interned_string name) {
   CHECK(registry.entities.count(name)) << "No such entity: " << name;
   return registry.entities.at(name);
 }
 
 vks::Expr* translate_expr(vks::Registry& registry, mnc::Expr* expr) {
   if (auto reference = dynamic_cast<mnc::Reference*>(expr)) {
-    auto result = new vks::Reference;
-    result->entity = lookup_entity(registry, reference->name);
-    return result;
+    return registry.reference_expr(lookup_entity(registry, reference->name));
   } else if (auto number = dynamic_cast<mnc::Number*>(expr)) {
-    auto result = new vks::Number;
-    result->number = number->number;
-    return result;
+    return registry.number_expr(number->number);
   } else {
     LOG(FATAL) << "Unknown expr: " << typeid(expr).name();
   }
@@ -489,22 +471,14 @@ vks::Expr* translate_expr(vks::Registry& registry, mnc::Expr* expr) {
 
 vks::Type* translate_type(vks::Registry& registry, mnc::Type* type) {
   if (auto name = dynamic_cast<mnc::Name*>(type)) {
-    auto result = new vks::Name;
-    result->entity = lookup_entity(registry, name->name);
-    return result;
+    return registry.name_type(lookup_entity(registry, name->name));
   } else if (auto const_ = dynamic_cast<mnc::Const*>(type)) {
-    auto result = new vks::Const;
-    result->T = translate_type(registry, const_->T);
-    return result;
+    return registry.const_type(translate_type(registry, const_->T));
   } else if (auto pointer = dynamic_cast<mnc::Pointer*>(type)) {
-    auto result = new vks::Pointer;
-    result->T = translate_type(registry, pointer->T);
-    return result;
+    return registry.pointer_type(translate_type(registry, pointer->T));
   } else if (auto array = dynamic_cast<mnc::Array*>(type)) {
-    auto result = new vks::Array;
-    result->T = translate_type(registry, array->T);
-    result->N = translate_expr(registry, array->N);
-    return result;
+    return registry.array_type(translate_type(registry, array->T),
+                               translate_expr(registry, array->N));
   }
   LOG(ERROR) << "Unknown mnc type: " << typeid(type).name();
   return nullptr;  // ???
@@ -567,9 +541,8 @@ void populate_entities(vks::Registry& registry) {
 void remove_disabled(vks::Registry& registry, const vkr::start& start) {
   for (const vkr::Extensions& extensions : start.extensions) {
     for (const vkr::Extension& extension : extensions.extension) {
-      std::string supported = extension.supported.value();
-      CHECK(supported == "disabled" || supported == "vulkan") << supported;
-      if (supported == "vulkan") continue;
+      if (extension.supported.value() == vkr::ExtensionSupport::vulkan)
+        continue;
 
       for (const vkr::Extension_require& require : extension.require) {
         for (auto command : require.command) {
@@ -589,7 +562,7 @@ void remove_disabled(vks::Registry& registry, const vkr::start& start) {
 
 void apply_constant_extends(
     vks::Registry& registry,
-    std::multimap<std::string, vks::Constant*>& extends) {
+    std::multimap<dvc::interned_string, vks::Constant*>& extends) {
   for (const auto& [extend, constant] : extends) {
     CHECK(registry.enumerations.count(extend))
         << "Could not find extension enumeration: " << extend << " for "
@@ -605,7 +578,7 @@ vks::Registry parse_registry(const vkr::start& start) {
 
   parse_platforms(registry, start);
   parse_externals(registry, start);
-  std::multimap<std::string, vks::Constant*> extends;
+  std::multimap<dvc::interned_string, vks::Constant*> extends;
   parse_constants(registry, extends, start);
   parse_enumerations(registry, start);
   parse_bitmasks(registry, start);